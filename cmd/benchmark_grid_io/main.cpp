@@ -0,0 +1,156 @@
+#include <Discregrid/All>
+#include <cxxopts/cxxopts.hpp>
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+
+double
+fileSizeInMB(std::string const& filename)
+{
+	auto in = std::ifstream(filename, std::ios::binary | std::ios::ate);
+	return static_cast<double>(in.tellg()) / (1024.0 * 1024.0);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	cxxopts::Options options(argv[0], "Measures the throughput of loading and saving a discrete grid.");
+	options.positional_help("[input file]");
+
+	options.add_options()
+	("h,help", "Prints this help text")
+	("n,repetitions", "Number of repetitions", cxxopts::value<unsigned int>()->default_value("5"))
+	("f,format", "File format of the saved grid, i.e. legacy, mappable or compressed", cxxopts::value<std::string>()->default_value("legacy"))
+	("o,output", "Temporary file for measuring the save throughput", cxxopts::value<std::string>()->default_value("benchmark.cdf"))
+	("input", "Discrete grid file in cdf format", cxxopts::value<std::vector<std::string>>())
+	;
+
+	try
+	{
+		options.parse_positional("input");
+		auto result = options.parse(argc, argv);
+
+		if (result.count("help"))
+		{
+			std::cout << options.help() << std::endl;
+			std::cout << std::endl << std::endl << "Example: BenchmarkGridIO -n 10 -f compressed dragon.cdf" << std::endl;
+			exit(0);
+		}
+		if (!result.count("input"))
+		{
+			std::cout << "ERROR: No input file given." << std::endl;
+			std::cout << options.help() << std::endl;
+			std::cout << std::endl << std::endl << "Example: BenchmarkGridIO -n 10 -f compressed dragon.cdf" << std::endl;
+			exit(1);
+		}
+		auto filename = result["input"].as<std::vector<std::string>>().front();
+		auto output = result["o"].as<std::string>();
+		auto n = std::max(result["n"].as<unsigned int>(), 1u);
+
+		using FileFormat = Discregrid::CubicLagrangeDiscreteGrid::FileFormat;
+		auto format_name = result["f"].as<std::string>();
+		auto format = FileFormat::Legacy;
+		if (!Discregrid::CubicLagrangeDiscreteGrid::parseFileFormat(format_name, format))
+		{
+			std::cout << "ERROR: Unknown file format " << format_name << "." << std::endl;
+			exit(1);
+		}
+
+		auto size = fileSizeInMB(filename);
+		std::cout << "File size: " << size << " MB" << std::endl;
+
+		Discregrid::CubicLagrangeDiscreteGrid grid;
+		auto load_time = 0.0;
+		auto save_time = 0.0;
+		auto reload_time = 0.0;
+		auto partial_time = 0.0;
+		for (auto i = 0u; i < n; ++i)
+		{
+			auto t0 = std::chrono::high_resolution_clock::now();
+			grid.load(filename);
+			auto t1 = std::chrono::high_resolution_clock::now();
+			grid.save(output, format);
+			auto t2 = std::chrono::high_resolution_clock::now();
+			grid.load(output);
+			auto t3 = std::chrono::high_resolution_clock::now();
+			// Only field 0 is read, the others are loaded on first use.
+			grid.load(output, std::vector<bool>{true});
+			auto t4 = std::chrono::high_resolution_clock::now();
+
+			load_time += std::chrono::duration<double>(t1 - t0).count();
+			save_time += std::chrono::duration<double>(t2 - t1).count();
+			reload_time += std::chrono::duration<double>(t3 - t2).count();
+			partial_time += std::chrono::duration<double>(t4 - t3).count();
+		}
+
+		load_time /= static_cast<double>(n);
+		save_time /= static_cast<double>(n);
+		reload_time /= static_cast<double>(n);
+		partial_time /= static_cast<double>(n);
+		auto output_size = fileSizeInMB(output);
+		std::cout << "Load: " << 1000.0 * load_time << " ms, " << size / load_time << " MB/s" << std::endl;
+		std::cout << "Saved file size (" << format_name << "): " << output_size << " MB" << std::endl;
+		std::cout << "Save: " << 1000.0 * save_time << " ms, " << output_size / save_time << " MB/s" << std::endl;
+		std::cout << "Load saved file: " << 1000.0 * reload_time << " ms, " << output_size / reload_time << " MB/s" << std::endl;
+		std::cout << "Load field 0 of saved file: " << 1000.0 * partial_time << " ms" << std::endl;
+
+		if (format == FileFormat::Mappable)
+		{
+			auto map_time = 0.0;
+			for (auto i = 0u; i < n; ++i)
+			{
+				auto t0 = std::chrono::high_resolution_clock::now();
+				Discregrid::MappedCubicLagrangeDiscreteGrid mapped(output);
+				auto t1 = std::chrono::high_resolution_clock::now();
+				map_time += std::chrono::duration<double>(t1 - t0).count();
+			}
+			std::cout << "Map: " << 1000.0 * map_time / static_cast<double>(n) << " ms" << std::endl;
+
+			// The mapped grid has to interpolate exactly like the loaded one, both for
+			// reduced fields and for fields whose cells are computed on the fly.
+			Discregrid::MappedCubicLagrangeDiscreteGrid mapped(output);
+			auto const& domain = grid.domain();
+			auto n_mismatches = 0;
+			for (auto f = 0; f < static_cast<int>(mapped.nFields()); ++f)
+			{
+				for (auto i = 0; i < 1000; ++i)
+				{
+					auto t = Discregrid::Vector3r((i % 10 + 0.5) / 10.0, (i / 10 % 10 + 0.5) / 10.0, (i / 100 + 0.5) / 10.0);
+					auto x = (domain.min() + t.cwiseProduct(domain.diagonal())).eval();
+					if (mapped.interpolate(f, x) != grid.interpolate(f, x))
+						++n_mismatches;
+				}
+			}
+			if (n_mismatches > 0)
+			{
+				std::cerr << "ERROR: The mapped grid deviates from the loaded grid at " << n_mismatches << " points!" << std::endl;
+				std::remove(output.c_str());
+				exit(1);
+			}
+			std::cout << "Mapped grid matches loaded grid" << std::endl;
+		}
+		if (format == FileFormat::Compressed)
+		{
+			// Compare with the same layout without compression.
+			grid.save(output, FileFormat::Mappable);
+			auto uncompressed_size = fileSizeInMB(output);
+			std::cout << "Compression ratio: " << uncompressed_size / output_size << std::endl;
+			std::cout << "Decompression: " << uncompressed_size / reload_time << " MB/s of uncompressed data" << std::endl;
+		}
+		std::remove(output.c_str());
+	}
+	catch (cxxopts::OptionException const& e)
+	{
+		std::cout << "error parsing options: " << e.what() << std::endl;
+		exit(1);
+	}
+
+	return 0;
+}
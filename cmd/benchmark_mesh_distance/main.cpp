@@ -0,0 +1,122 @@
+#include <Discregrid/All>
+#include <cxxopts/cxxopts.hpp>
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+
+using namespace Eigen;
+
+namespace
+{
+
+struct Measurement
+{
+	double setup_time;
+	double query_time;
+	std::vector<double> distances;
+};
+
+Measurement
+measure(Discregrid::TriangleMesh const& mesh, Discregrid::MeshDistance::Hierarchy hierarchy,
+	std::vector<Vector3d> const& points)
+{
+	auto m = Measurement{};
+	auto t0 = std::chrono::high_resolution_clock::now();
+	Discregrid::MeshDistance md(&mesh, true, hierarchy);
+	auto t1 = std::chrono::high_resolution_clock::now();
+
+	m.distances.resize(points.size());
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < static_cast<int>(points.size()); ++i)
+	{
+		m.distances[i] = md.signedDistance(points[i].cast<Discregrid::real>());
+	}
+	auto t2 = std::chrono::high_resolution_clock::now();
+
+	m.setup_time = std::chrono::duration<double>(t1 - t0).count();
+	m.query_time = std::chrono::duration<double>(t2 - t1).count();
+	return m;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	cxxopts::Options options(argv[0], "Measures the setup and query times of the distance computation to a triangle mesh for the available bounding volume hierarchies.");
+	options.positional_help("[input OBJ file]");
+
+	options.add_options()
+	("h,help", "Prints this help text")
+	("n,queries", "Number of query points", cxxopts::value<unsigned int>()->default_value("1000000"))
+	("b,band", "Relative enlargement of the bounding box of the mesh, in which the query points are sampled uniformly", cxxopts::value<double>()->default_value("0.1"))
+	("input", "OBJ file containing input triangle mesh", cxxopts::value<std::vector<std::string>>())
+	;
+
+	try
+	{
+		options.parse_positional("input");
+		auto result = options.parse(argc, argv);
+
+		if (result.count("help"))
+		{
+			std::cout << options.help() << std::endl;
+			std::cout << std::endl << std::endl << "Example: BenchmarkMeshDistance -n 100000 dragon.obj" << std::endl;
+			exit(0);
+		}
+		if (!result.count("input"))
+		{
+			std::cout << "ERROR: No input mesh given." << std::endl;
+			std::cout << options.help() << std::endl;
+			std::cout << std::endl << std::endl << "Example: BenchmarkMeshDistance -n 100000 dragon.obj" << std::endl;
+			exit(1);
+		}
+		auto filename = result["input"].as<std::vector<std::string>>().front();
+		if (!std::ifstream(filename).good())
+		{
+			std::cerr << "ERROR: Input file does not exist!" << std::endl;
+			exit(1);
+		}
+
+		Discregrid::TriangleMesh mesh(filename);
+		std::cout << "Triangles: " << mesh.nFaces() << std::endl;
+
+		AlignedBox3d domain;
+		for (auto const& x : mesh.vertices())
+			domain.extend(x.cast<double>());
+		auto band = result["b"].as<double>() * domain.diagonal();
+		domain.min() -= band;
+		domain.max() += band;
+
+		auto n = std::max(result["n"].as<unsigned int>(), 1u);
+		auto points = std::vector<Vector3d>(n);
+		std::mt19937 generator(0u);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		for (auto& x : points)
+			x = domain.min() + Vector3d(uniform(generator), uniform(generator), uniform(generator)).cwiseProduct(domain.diagonal());
+
+		using Hierarchy = Discregrid::MeshDistance::Hierarchy;
+		auto spheres = measure(mesh, Hierarchy::BoundingSpheres, points);
+		auto boxes = measure(mesh, Hierarchy::WideBoxes, points);
+
+		auto max_deviation = 0.0;
+		for (auto i = 0u; i < n; ++i)
+			max_deviation = std::max(max_deviation, std::abs(spheres.distances[i] - boxes.distances[i]));
+
+		std::cout << "Bounding spheres: setup " << 1000.0 * spheres.setup_time << " ms, "
+			<< 1.0e6 * spheres.query_time / n << " us per query" << std::endl;
+		std::cout << "Wide boxes: setup " << 1000.0 * boxes.setup_time << " ms, "
+			<< 1.0e6 * boxes.query_time / n << " us per query" << std::endl;
+		std::cout << "Query speedup: " << spheres.query_time / boxes.query_time << std::endl;
+		std::cout << "Maximum deviation of the distances: " << max_deviation << std::endl;
+	}
+	catch (cxxopts::OptionException const& e)
+	{
+		std::cout << "error parsing options: " << e.what() << std::endl;
+		exit(1);
+	}
+
+	return 0;
+}
@@ -70,11 +70,16 @@ int main(int argc, char* argv[])
 		auto lastindex = filename.find_last_of(".");
 		auto extension = filename.substr(lastindex + 1, filename.length() - lastindex);
 
+		auto field_id = result["f"].as<unsigned int>();
+
 		std::cout << "Load SDF...";
 		if (extension == "cdf" || extension == "cdm")
 		{
+			// Only the sampled field is read.
+			auto field_mask = std::vector<bool>(field_id + 1u, false);
+			field_mask[field_id] = true;
 			sdf = std::unique_ptr<Discregrid::CubicLagrangeDiscreteGrid>(
-				new Discregrid::CubicLagrangeDiscreteGrid(filename));
+				new Discregrid::CubicLagrangeDiscreteGrid(filename, field_mask));
 		}
 		std::cout << "DONE" << std::endl;
 
@@ -112,8 +117,6 @@ int main(int argc, char* argv[])
 		auto data = std::vector<double>{};
 		data.resize(xsamples * ysamples);
 
-		auto field_id = result["f"].as<unsigned int>();
-
 		std::cout << "Sample field...";
 #pragma omp parallel for
 		for (int k = 0; k < static_cast<int>(xsamples * ysamples); ++k)
@@ -37,6 +37,7 @@ int main(int argc, char* argv[])
 	("i,invert", "Invert field")
 	("s,smoothing_length", "Kernel smoothing length", cxxopts::value<double>()->default_value("0.1"))
 	("o,output", "Ouput file in cdf format", cxxopts::value<std::string>()->default_value(""))
+	("f,format", "File format of the output, i.e. legacy, mappable or compressed. Only legacy files can be read by earlier versions of Discregrid", cxxopts::value<std::string>()->default_value("legacy"))
 	("no-reduction", "Disables discarding of cells for sparse layout.")
 	("input", "Discrete grid file containing input SDF in field 0", cxxopts::value<std::vector<std::string>>())
 	;
@@ -61,13 +62,20 @@ int main(int argc, char* argv[])
 		}
 		auto filename = result["input"].as<std::vector<std::string>>().front();
 
+		auto format = Discregrid::CubicLagrangeDiscreteGrid::FileFormat::Legacy;
+		if (!Discregrid::CubicLagrangeDiscreteGrid::parseFileFormat(result["f"].as<std::string>(), format))
+		{
+			std::cout << "ERROR: Unknown file format " << result["f"].as<std::string>() << "." << std::endl;
+			exit(1);
+		}
+
 		if (!std::ifstream(filename).good())
 		{
 			std::cerr << "ERROR: Input file does not exist!" << std::endl;
 			exit(1);
 		}
 
-		auto sdf = std::unique_ptr<Discregrid::DiscreteGrid>{};
+		auto sdf = std::unique_ptr<Discregrid::CubicLagrangeDiscreteGrid>{};
 
 		auto lastindex = filename.find_last_of(".");
 		auto extension = filename.substr(lastindex + 1, filename.length() - lastindex);
@@ -75,8 +83,9 @@ int main(int argc, char* argv[])
 		std::cout << "Load SDF...";
 		if (extension == "cdf")
 		{
+			// Only the signed distance field is read.
 			sdf = std::unique_ptr<Discregrid::CubicLagrangeDiscreteGrid>(
-				new Discregrid::CubicLagrangeDiscreteGrid(filename));
+				new Discregrid::CubicLagrangeDiscreteGrid(filename, std::vector<bool>{true}));
 		}
 		std::cout << "DONE" << std::endl;
 
@@ -116,33 +125,30 @@ int main(int argc, char* argv[])
 
 		auto cell_diag = sdf->cellSize().norm();
 		std::cout << "Generate density map..." << std::endl;
-		sdf->addFunction(density_func, true, [&](Vector3d const& x_)
+		if (no_reduction)
 		{
-			if (no_reduction)
-			{
-				return true;
-			}
-			auto x = x_.cwiseMax(sdf->domain().min()).cwiseMin(sdf->domain().max());
-			auto dist = sdf->interpolate(0u, x);
-			if (dist == std::numeric_limits<double>::max())
+			sdf->addFunction(density_func, true);
+		}
+		else
+		{
+			// Only cells close to the boundary are discretized. The distance at the cell
+			// center is widened by the cell diagonal to account for the cell extent.
+			sdf->addSparseFunction(density_func, [&](AlignedBox3d const& cell)
 			{
-				return false;
-			}
+				auto dist = sdf->interpolate(0u, cell.center());
+				if (dist == std::numeric_limits<double>::max())
+				{
+					return false;
+				}
 
-			return -6.0 * h < dist + cell_diag && dist - cell_diag < 2.0 * h;
-		});
+				return -6.0 * h < dist + cell_diag && dist - cell_diag < 2.0 * h;
+			}, true);
 
-		if (result["no-reduction"].count() == 0u)
-		{
 			std::cout << "Reduce discrete fields...";
 			sdf->reduceField(0u, [&](const Vector3d &, double v)
 			{
 				return -6.0 * h < v + cell_diag && v - cell_diag < 2.0 * h;
 			});
-			sdf->reduceField(1u, [&](const Vector3d &, double v)
-			{
-				return 0.0 <= v && v <= 3.0 * rho0;
-			});
 			std::cout << "DONE" << std::endl;
 		}
 
@@ -158,7 +164,7 @@ int main(int argc, char* argv[])
 			}
 			output_file += ".cdm";
 		}
-		sdf->save(output_file);
+		sdf->save(output_file, format);
 		std::cout << "DONE" << std::endl;
 	}
 	catch (cxxopts::OptionException const& e)
@@ -16,6 +16,12 @@ std::istream& operator>>(std::istream& is, std::array<unsigned int, 3>& data)
 	return is;  
 }  
 
+std::istream& operator>>(std::istream& is, std::array<unsigned int, 2>& data)
+{
+	is >> data[0] >> data[1];
+	return is;
+}
+
 std::istream& operator>>(std::istream& is, AlignedBox3d& data)  
 {  
 	is	>> data.min()[0] >> data.min()[1] >> data.min()[2]
@@ -35,7 +41,10 @@ int main(int argc, char* argv[])
 	("r,resolution", "Grid resolution", cxxopts::value<std::array<unsigned int, 3>>()->default_value("10 10 10"))
 	("d,domain", "Domain extents (bounding box), format: \"minX minY minZ maxX maxY maxZ\"", cxxopts::value<AlignedBox3d>())
 	("i,invert", "Invert SDF")
+	("b,band", "Only discretize the SDF in a narrow band of the given width around the surface (scan conversion)", cxxopts::value<double>())
+	("s,shard", "Only generate shard k of n, format: \"k n\". The grid is split into n slabs along the z-axis and k is inserted before the extension of the output file; the shards can be merged using MergeGrids", cxxopts::value<std::array<unsigned int, 2>>())
 	("o,output", "Ouput file in cdf format", cxxopts::value<std::string>()->default_value(""))
+	("f,format", "File format of the output, i.e. legacy, mappable or compressed. Only legacy files can be read by earlier versions of Discregrid", cxxopts::value<std::string>()->default_value("legacy"))
 	("input", "OBJ file containing input triangle mesh", cxxopts::value<std::vector<std::string>>())
 	;
 
@@ -60,6 +69,13 @@ int main(int argc, char* argv[])
 		auto resolution = result["r"].as<std::array<unsigned int, 3>>();
 		auto filename = result["input"].as<std::vector<std::string>>().front();
 
+		auto format = Discregrid::CubicLagrangeDiscreteGrid::FileFormat::Legacy;
+		if (!Discregrid::CubicLagrangeDiscreteGrid::parseFileFormat(result["f"].as<std::string>(), format))
+		{
+			std::cout << "ERROR: Unknown file format " << result["f"].as<std::string>() << "." << std::endl;
+			exit(1);
+		}
+
 		if (!std::ifstream(filename).good())
 		{
 			std::cerr << "ERROR: Input file does not exist!" << std::endl;
@@ -71,7 +87,7 @@ int main(int argc, char* argv[])
 		std::cout << "DONE" << std::endl;
 
 		std::cout << "Set up data structures...";
-		Discregrid::MeshDistance md(mesh);
+		Discregrid::MeshDistance md(&mesh);
 		std::cout << "DONE" << std::endl;
 
 		Eigen::AlignedBox3d domain;
@@ -90,19 +106,46 @@ int main(int argc, char* argv[])
 			domain.min() -= 1.0e-3 * domain.diagonal().norm() * Vector3d::Ones();
 		}
 
-		Discregrid::CubicLagrangeDiscreteGrid sdf(domain, resolution);
+		Discregrid::CubicLagrangeDiscreteGrid sdf(domain.cast<Discregrid::real>(),
+			Vector3i(resolution[0], resolution[1], resolution[2]));
+		auto shard = std::array<unsigned int, 2>{{0u, 1u}};
+		if (result.count("shard"))
+		{
+			shard = result["shard"].as<std::array<unsigned int, 2>>();
+			if (shard[0] >= shard[1] || shard[1] > resolution[2])
+			{
+				std::cerr << "ERROR: Invalid shard. The shard index has to be smaller than the number of shards, which may not exceed the resolution in z-direction." << std::endl;
+				exit(1);
+			}
+			auto z_begin = static_cast<int>(shard[0] * resolution[2] / shard[1]);
+			auto z_end = static_cast<int>((shard[0] + 1) * resolution[2] / shard[1]);
+			sdf = sdf.shard(Vector3i(0, 0, z_begin), Vector3i(resolution[0], resolution[1], z_end));
+		}
+
 		auto func = Discregrid::DiscreteGrid::ContinuousFunction{};
 		if (result.count("invert"))
 		{
-			func = [&md](Vector3d const& xi) {return -1.0 * md.signedDistanceCached(xi); };
+			func = [&md](Discregrid::Vector3r const& xi) {return -1.0 * md.signedDistance(xi); };
 		}
 		else
 		{
-			func = [&md](Vector3d const& xi) {return md.signedDistanceCached(xi); };
+			func = [&md](Discregrid::Vector3r const& xi) {return md.signedDistance(xi); };
 		}
 
 		std::cout << "Generate discretization..." << std::endl;
-		sdf.addFunction(func, true);
+		if (result.count("band"))
+		{
+			if (result.count("invert"))
+			{
+				std::cerr << "ERROR: Inverted SDFs can not be generated in a narrow band." << std::endl;
+				exit(1);
+			}
+			sdf.addNarrowBandDistance(md, static_cast<Discregrid::real>(result["band"].as<double>()), true);
+		}
+		else
+		{
+			sdf.addFunction(func, true);
+		}
 		std::cout << "DONE" << std::endl;
 
 		std::cout << "Serialize discretization...";
@@ -117,7 +160,18 @@ int main(int argc, char* argv[])
 			}
 			output_file += ".cdf";
 		}
-		sdf.save(output_file);
+		if (result.count("shard"))
+		{
+			// Each shard is written to its own file, e.g. dragon.cdf becomes dragon.k.cdf.
+			auto lastindex = output_file.find_last_of(".");
+			auto separator = output_file.find_last_of("/\\");
+			if (lastindex == std::string::npos || (separator != std::string::npos && lastindex < separator))
+			{
+				lastindex = output_file.size();
+			}
+			output_file.insert(lastindex, "." + std::to_string(shard[0]));
+		}
+		sdf.save(output_file, format);
 		std::cout << "DONE" << std::endl;
 	}
 	catch (cxxopts::OptionException const& e)
@@ -0,0 +1,65 @@
+#include <Discregrid/All>
+#include <cxxopts/cxxopts.hpp>
+
+#include <string>
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+	cxxopts::Options options(argv[0], "Merges shards of a discrete grid, e.g. generated by separate processes, into a single grid.");
+	options.positional_help("[input shard files]");
+
+	options.add_options()
+	("h,help", "Prints this help text")
+	("o,output", "Output file in cdf format", cxxopts::value<std::string>()->default_value("merged.cdf"))
+	("f,format", "File format of the output, i.e. legacy, mappable or compressed. Only legacy files can be read by earlier versions of Discregrid", cxxopts::value<std::string>()->default_value("legacy"))
+	("input", "Shard files in cdf format", cxxopts::value<std::vector<std::string>>())
+	;
+
+	try
+	{
+		options.parse_positional("input");
+		auto result = options.parse(argc, argv);
+
+		if (result.count("help"))
+		{
+			std::cout << options.help() << std::endl;
+			std::cout << std::endl << std::endl << "Example: MergeGrids -o dragon.cdf dragon.0.cdf dragon.1.cdf" << std::endl;
+			exit(0);
+		}
+		if (!result.count("input"))
+		{
+			std::cout << "ERROR: No input shards given." << std::endl;
+			std::cout << options.help() << std::endl;
+			std::cout << std::endl << std::endl << "Example: MergeGrids -o dragon.cdf dragon.0.cdf dragon.1.cdf" << std::endl;
+			exit(1);
+		}
+		auto filenames = result["input"].as<std::vector<std::string>>();
+
+		auto format = Discregrid::CubicLagrangeDiscreteGrid::FileFormat::Legacy;
+		if (!Discregrid::CubicLagrangeDiscreteGrid::parseFileFormat(result["f"].as<std::string>(), format))
+		{
+			std::cout << "ERROR: Unknown file format " << result["f"].as<std::string>() << "." << std::endl;
+			exit(1);
+		}
+
+		std::cout << "Merge shards..." << std::endl;
+		Discregrid::CubicLagrangeDiscreteGrid grid;
+		if (!grid.merge(filenames, true))
+		{
+			exit(1);
+		}
+		std::cout << "DONE" << std::endl;
+
+		std::cout << "Serialize discretization...";
+		grid.save(result["o"].as<std::string>(), format);
+		std::cout << "DONE" << std::endl;
+	}
+	catch (cxxopts::OptionException const& e)
+	{
+		std::cout << "error parsing options: " << e.what() << std::endl;
+		exit(1);
+	}
+
+	return 0;
+}
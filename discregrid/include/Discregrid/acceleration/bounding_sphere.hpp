@@ -1,6 +1,8 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <random>
 #include <vector>
 
 namespace Discregrid
@@ -107,6 +109,29 @@ public:
 		m_x += a;
 	}
 
+	/**
+	 * \brief	constructs the smallest sphere enclosing two spheres
+	 *
+	 * \param a first sphere
+	 * \param b second sphere
+	 */
+	BoundingSphere(const BoundingSphere& a, const BoundingSphere& b)
+	{
+		const real d = (b.m_x - a.m_x).norm();
+		if (d + b.m_r <= a.m_r)
+		{
+			*this = a;
+			return;
+		}
+		if (d + a.m_r <= b.m_r)
+		{
+			*this = b;
+			return;
+		}
+		m_r = 0.5 * (d + a.m_r + b.m_r);
+		m_x = a.m_x + (m_r - a.m_r) / d * (b.m_x - a.m_x);
+	}
+
 	/**
 	 * \brief	constructs the smallest enclosing sphere a given pointset
 	 *
@@ -154,8 +179,19 @@ public:
 	 */
 	void setPoints(const std::vector<Vector3r>& p)
 	{
-		//remove duplicates
 		std::vector<Vector3r> v(p);
+		setPointsInPlace(v, static_cast<unsigned int>(rand()));
+	}
+
+	/**
+	 * \brief	constructs the smallest enclosing sphere a given pointset without copying it
+	 *
+	 * \param v	vertices of the points, which are reordered, perturbed and deduplicated
+	 * \param seed	seed of the random permutation and perturbation of the points
+	 */
+	void setPointsInPlace(std::vector<Vector3r>& v, unsigned int seed)
+	{
+		//remove duplicates
 		std::sort(v.begin(), v.end(), [](const Vector3r& a, const Vector3r& b)
 			{
 				if (a[0] < b[0]) return true;
@@ -171,10 +207,19 @@ public:
 
 		//generate random permutation of the points and perturb the points by epsilon to avoid corner cases
 		const real epsilon = 1.0e-6;
+		if (n < 2)
+		{
+			m_x = n == 1 ? v[0] : Vector3r::Zero();
+			m_r = epsilon;
+			return;
+		}
+
+		std::minstd_rand random(seed);
+		auto uniform = [&]() { return real(random() - random.min()) / real(random.max() - random.min()); };
 		for (int i = n - 1; i > 0; i--)
 		{
-			const Vector3r epsilon_vec = epsilon * Vector3r::Random();
-			const int j = static_cast<int>(floor(i * real(rand()) / RAND_MAX));
+			const Vector3r epsilon_vec = epsilon * Vector3r(2 * uniform() - 1, 2 * uniform() - 1, 2 * uniform() - 1);
+			const int j = static_cast<int>(random() % static_cast<unsigned int>(i + 1));
 			d = v[i] + epsilon_vec;
 			v[i] = v[j] - epsilon_vec;
 			v[j] = d;
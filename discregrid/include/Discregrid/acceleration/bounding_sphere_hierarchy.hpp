@@ -21,6 +21,8 @@ public:
 
 	Vector3r const& entityPosition(int i) const final;
 	void computeHull(int b, int n, BoundingSphere& hull) const final;
+	void mergeHulls(int b, int n, BoundingSphere const& hull0, BoundingSphere const& hull1,
+		BoundingSphere& hull) const final;
 
 private:
 
@@ -41,6 +43,8 @@ public:
 
 	Vector3r const& entityPosition(int i) const final;
 	void computeHull(int b, int n, AlignedBox3r& hull) const final;
+	void mergeHulls(int b, int n, AlignedBox3r const& hull0, AlignedBox3r const& hull1,
+		AlignedBox3r& hull) const final;
 
 private:
 
@@ -65,6 +69,8 @@ public:
 	Vector3r const& entityPosition(int i) const final;
 	void computeHull(int b, int n, BoundingSphere& hull)
 		const final;
+	void mergeHulls(int b, int n, BoundingSphere const& hull0, BoundingSphere const& hull1,
+		BoundingSphere& hull) const final;
 
 private:
 
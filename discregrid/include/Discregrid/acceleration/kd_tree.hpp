@@ -64,19 +64,43 @@ public:
         TraversalPriorityLess const& pless = nullptr) const;
     void traverseBreadthFirst(TraversalPredicate const& pred, TraversalCallback const& cb, int start_node = 0, TraversalPriorityLess const& pless = nullptr, TraversalQueue& pending = TraversalQueue()) const;
 
+    // Visits the nodes in the same order as traverseDepthFirst, but iterates on
+    // an explicit stack of fixed size and takes the functors by reference, such
+    // that they are inlined and no closures are allocated or copied per node.
+    // pless(children) returns whether children[0] is visited first.
+    template <typename Predicate, typename Callback, typename PriorityLess>
+    void traverseDepthFirstInline(Predicate&& pred, Callback&& cb,
+        PriorityLess&& pless) const;
+
+    // Bound of the depth of the tree, as each node holds at most half of the
+    // entities of its parent.
+    static constexpr int maxDepth() { return 32; }
+
+    // Nodes holding more entities obtain their hull from the hulls of their
+    // children by mergeHulls instead of from all of their entities.
+    static int maxEntityHullSize() { return 256; }
+
 protected:
 
     void construct(int node, AlignedBox3r const& box,
         int b, int n);
+    void computeNodeHull(int node);
     void traverseDepthFirst(int node, int depth,
         TraversalPredicate pred, TraversalCallback cb, TraversalPriorityLess const& pless) const;
     void traverseBreadthFirst(TraversalQueue& pending,
         TraversalPredicate const& pred, TraversalCallback const& cb, TraversalPriorityLess const& pless = nullptr) const;
 
-    int addNode(int b, int n);
+    // Number of nodes of the subtrees holding n and n + 1 entities, as the shape
+    // of a subtree only depends on its number of entities.
+    static std::array<int, 2> subtreeSizes(int n);
 
     virtual Vector3r const& entityPosition(int i) const = 0;
+    // Both functions are called concurrently for disjoint nodes.
     virtual void computeHull(int b, int n, HullType& hull) const = 0;
+    // Computes the hull of entities b to b + n - 1 enclosing the hulls of both
+    // halves, which defaults to computeHull.
+    virtual void mergeHulls(int b, int n, HullType const&, HullType const&,
+        HullType& hull) const { computeHull(b, n, hull); }
 
 protected:
 
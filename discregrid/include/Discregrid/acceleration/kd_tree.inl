@@ -16,17 +16,32 @@ KDTree<HullType>::construct()
     for (auto i = 0u; i < m_lst.size(); ++i)
         box.extend(entityPosition(i));
 
-    auto ni = addNode(0, static_cast<int>(m_lst.size()));
-    construct(ni, box, 0, static_cast<int>(m_lst.size()));
+    // The nodes are stored in depth-first order, such that the index of each
+    // node is known before its siblings are constructed and the subtrees can
+    // be constructed concurrently.
+    auto n = static_cast<int>(m_lst.size());
+    m_nodes.resize(subtreeSizes(n)[0]);
+    m_hulls.resize(m_nodes.size());
+#pragma omp parallel
+    {
+#pragma omp single
+        construct(0, box, 0, n);
+    }
 }
 
 template<typename HullType> void
 KDTree<HullType>::construct(int node, AlignedBox3r const& box, int b,
     int n)
 {
+    m_nodes[node] = Node(b, n);
+
     // If only one element is left end recursion.
     //if (n == 1) return;
-    if (n < 10) return;
+    if (n < 10)
+    {
+        computeNodeHull(node);
+        return;
+    }
 
     // Determine longest side of bounding box.
     auto max_dir = 0;
@@ -44,28 +59,65 @@ KDTree<HullType>::construct(int node, AlignedBox3r const& box, int b,
     }
 #endif
 
-    // Sort range according to center of the longest side.
-    std::sort(m_lst.begin() + b, m_lst.begin() + b + n, 
-        [&](int a, int b)
-        {
-            return entityPosition(a)(max_dir) < entityPosition(b)(max_dir);
-        }
-    );
-
+    // Partition range at the median along the longest side.
+    auto less = [&](int a, int b)
+    {
+        return entityPosition(a)(max_dir) < entityPosition(b)(max_dir);
+    };
     auto hal = n / 2;
-    auto n0 = addNode(b      , hal    );
-    auto n1 = addNode(b + hal, n - hal);
+    std::nth_element(m_lst.begin() + b, m_lst.begin() + b + hal, m_lst.begin() + b + n, less);
+
+    auto n0 = node + 1;
+    auto n1 = node + 1 + subtreeSizes(hal)[0];
     m_nodes[node].children[0] = n0;
     m_nodes[node].children[1] = n1;
 
     auto c = 0.5 * (
-        entityPosition(m_lst[b + hal -1])(max_dir) + 
+        entityPosition(*std::max_element(m_lst.begin() + b, m_lst.begin() + b + hal, less))(max_dir) +
         entityPosition(m_lst[b + hal   ])(max_dir));
     auto l_box = box; l_box.max()(max_dir) = c;
     auto r_box = box; r_box.min()(max_dir) = c;
 
-    construct(m_nodes[node].children[0], l_box, b, hal);
-    construct(m_nodes[node].children[1], r_box, b + hal, n - hal);
+    // The entities of the node are reordered by the construction of its
+    // children, hence its hull is computed before or after them.
+    if (n <= maxEntityHullSize())
+        computeNodeHull(node);
+
+#pragma omp task if (n > 4096)
+    construct(n0, l_box, b, hal);
+    construct(n1, r_box, b + hal, n - hal);
+#pragma omp taskwait
+
+    if (n > maxEntityHullSize())
+        computeNodeHull(node);
+}
+
+template<typename HullType> void
+KDTree<HullType>::computeNodeHull(int node)
+{
+    auto const& nd = m_nodes[node];
+    if (nd.isLeaf() || nd.n <= maxEntityHullSize())
+        computeHull(nd.begin, nd.n, m_hulls[node]);
+    else
+        mergeHulls(nd.begin, nd.n, m_hulls[nd.children[0]], m_hulls[nd.children[1]], m_hulls[node]);
+}
+
+template<typename HullType> std::array<int, 2>
+KDTree<HullType>::subtreeSizes(int n)
+{
+    if (n + 1 < 10)
+        return {{1, 1}};
+
+    // The halves of n and n + 1 entities hold n / 2 or n / 2 + 1 entities.
+    auto half = n / 2;
+    auto half_sizes = subtreeSizes(half);
+    auto size = [&](int m) -> int
+    {
+        if (m < 10)
+            return 1;
+        return 1 + half_sizes[m / 2 - half] + half_sizes[m - m / 2 - half];
+    };
+    return {{size(n), size(n + 1)}};
 }
 
 template<typename HullType> void
@@ -155,6 +207,36 @@ KDTree<HullType>::traverseDepthFirst(int node_index,
         //}
 }
 
+template <typename HullType>
+template <typename Predicate, typename Callback, typename PriorityLess> void
+KDTree<HullType>::traverseDepthFirstInline(Predicate&& pred, Callback&& cb,
+    PriorityLess&& pless) const
+{
+    if (m_nodes.empty() || !pred(0, 0))
+        return;
+
+    // The second child of each node on the path is pending, hence the stack
+    // never holds more than one node per level.
+    QueueItem pending[maxDepth() + 1];
+    auto n_pending = 0;
+    pending[n_pending++] = { 0, 0 };
+    while (n_pending > 0)
+    {
+        auto n = pending[--n_pending].n;
+        auto d = pending[n_pending].d;
+        auto const& node = m_nodes[n];
+
+        cb(n, d);
+        auto is_pred = pred(n, d);
+        if (!node.isLeaf() && is_pred)
+        {
+            auto first = pless(node.children) ? 0 : 1;
+            pending[n_pending++] = { node.children[1 - first], d + 1 };
+            pending[n_pending++] = { node.children[first], d + 1 };
+        }
+    }
+}
+
 
 template <typename HullType> void
 KDTree<HullType>::traverseBreadthFirst(TraversalPredicate const& pred, 
@@ -168,27 +250,13 @@ KDTree<HullType>::traverseBreadthFirst(TraversalPredicate const& pred,
     traverseBreadthFirst(pending, pred, cb, pless);
 }
 
-template <typename HullType> int
-KDTree<HullType>::addNode(int b, int n)
-{
-    HullType hull;
-    computeHull(b, n, hull);
-    m_hulls.push_back(hull);
-    m_nodes.push_back({ b, n });
-    return static_cast<int>(m_nodes.size() - 1);
-}
-
 template <typename HullType> void
 KDTree<HullType>::update()
 {
-    traverseDepthFirst(
-        [&](int, int) { return true; },
-        [&](int node_index, int)
-        {
-            auto const& nd = node(node_index);
-            computeHull(nd.begin, nd.n, hull(node_index));
-        }
-    );
+    // Children are stored after their parent, hence the hulls are updated
+    // bottom-up when iterating in reverse order.
+    for (auto i = static_cast<int>(m_nodes.size()) - 1; i >= 0; --i)
+        computeNodeHull(i);
 }
 
 template <typename HullType> void 
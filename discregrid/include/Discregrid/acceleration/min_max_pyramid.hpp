@@ -0,0 +1,65 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace Discregrid
+{
+
+/**
+ * @brief Bounds of the coefficients of a discrete field over blocks of cells.
+ *
+ * The lowest level holds the range of the coefficients of each block of blockSize()^3 cells
+ * and every further level merges 2^3 blocks of the level below, until a single block covers
+ * the grid. Cells whose coefficients are not all defined do not contribute to the ranges, i.e.
+ * blocks without such cells have an empty range. The pyramid does not reference the field
+ * and therefore has to be rebuilt when the field is modified.
+ */
+class MinMaxPyramid
+{
+public:
+
+	// Determines the range of the coefficients of cell l and returns whether the
+	// cell is defined.
+	using CellRange = std::function<bool(int l, real& min, real& max)>;
+	using RangePredicate = std::function<bool(real min, real max)>;
+
+	MinMaxPyramid() = default;
+	// Builds the pyramid for a grid of the given resolution, where cell_range is
+	// evaluated concurrently.
+	MinMaxPyramid(Eigen::Vector3i const& resolution, CellRange const& cell_range);
+
+	static int blockSize() { return 4; }
+
+	bool empty() const { return m_levels.empty(); }
+	Eigen::Vector3i const& cellResolution() const { return m_cell_resolution; }
+	int nLevels() const { return static_cast<int>(m_levels.size()); }
+	// Number of blocks along each axis of the given level.
+	Eigen::Vector3i const& resolution(int level) const { return m_levels[level].resolution; }
+	std::array<real, 2> const& range(int level, int block) const { return m_levels[level].ranges[block]; }
+
+	// Returns the indices of the blocks of the lowest level in ascending order,
+	// whose non-empty range and the ranges of all blocks containing them fulfill
+	// pred. The predicate has to hold for a range if it holds for any subrange.
+	std::vector<int> findBlocks(RangePredicate const& pred) const;
+
+	// Returns the cells l of block b of the lowest level in ascending order.
+	std::vector<int> blockCells(int b) const;
+
+private:
+
+	struct Level
+	{
+		Eigen::Vector3i resolution;
+		std::vector<std::array<real, 2>> ranges;
+	};
+
+	Eigen::Vector3i m_cell_resolution = Eigen::Vector3i::Zero();
+	// Levels from the finest to the coarsest one.
+	std::vector<Level> m_levels;
+};
+
+}
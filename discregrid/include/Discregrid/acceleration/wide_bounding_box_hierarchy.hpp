@@ -0,0 +1,134 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <span.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace Discregrid
+{
+
+/**
+ * @brief Hierarchy of axis-aligned bounding boxes over the triangles of a mesh with four children per node.
+ *
+ * The triangles are partitioned by the surface area heuristic, which is evaluated on bins of the triangle
+ * centers along the axis of their largest extent. The children of a node are found by repeatedly splitting
+ * the child with the largest surface area. Each node stores the boxes of its children as a structure of
+ * arrays, such that the distances from a point to all of them are computed at once by SIMD instructions.
+ */
+class TriangleMeshWideBBH
+{
+public:
+
+	struct Node
+	{
+		// Bounds of the child boxes per axis, where unused children have empty boxes.
+		std::array<std::array<real, 4>, 3> min;
+		std::array<std::array<real, 4>, 3> max;
+
+		// A leaf child holds counts[c] > 0 entities starting at index children[c],
+		// otherwise children[c] is the index of the child node or -1 if unused.
+		std::array<int, 4> children;
+		std::array<int, 4> counts;
+	};
+
+	TriangleMeshWideBBH(std::span<const Vector3r> vertices,
+		std::span<const Eigen::Vector3i> faces);
+
+	static int width() { return 4; }
+	static int maxLeafSize() { return 4; }
+	// Deeper nodes are not split further, which bounds the traversal stack.
+	static constexpr int maxDepth() { return 64; }
+
+	void construct();
+
+	Node const& node(int i) const { return m_nodes[i]; }
+	int nNodes() const { return static_cast<int>(m_nodes.size()); }
+	int entity(int i) const { return m_lst[i]; }
+
+	// Visits the leaves closer to x than sqrt(sq_dist) in the order of increasing
+	// distance and calls cb(f) for each of their triangles f. The callback may
+	// decrease sq_dist, which prunes the remaining leaves.
+	template <typename Callback>
+	void traverseNearestFirst(Vector3r const& x, real const& sq_dist, Callback&& cb) const;
+
+private:
+
+	struct Range
+	{
+		int begin, n;
+		AlignedBox3r box, centers;
+	};
+
+	int addNode(Range const& range, int depth);
+	void split(Range const& range, Range& left, Range& right);
+
+	std::span<const Vector3r> m_vertices;
+	std::span<const Eigen::Vector3i> m_faces;
+
+	std::vector<int> m_lst;
+	std::vector<Node> m_nodes;
+
+	// Only needed during construction.
+	std::vector<Vector3r> m_tri_centers;
+	std::vector<AlignedBox3r> m_tri_boxes;
+};
+
+template <typename Callback> void
+TriangleMeshWideBBH::traverseNearestFirst(Vector3r const& x, real const& sq_dist, Callback&& cb) const
+{
+	using Array4r = Eigen::Array<real, 4, 1>;
+
+	if (m_nodes.empty())
+		return;
+
+	// Each visited node replaces itself by at most four children on the stack.
+	struct Item { int node; real sq_dist; };
+	Item pending[3 * maxDepth() + 4];
+	auto n_pending = 0;
+	pending[n_pending++] = { 0, real(0) };
+	while (n_pending > 0)
+	{
+		auto item = pending[--n_pending];
+		if (!(item.sq_dist < sq_dist))
+			continue;
+
+		// Squared distances from x to the four child boxes.
+		auto const& node = m_nodes[item.node];
+		auto d = Array4r::Zero().eval();
+		for (auto a = 0; a < 3; ++a)
+		{
+			auto e = (Array4r::Map(node.min[a].data()) - x[a]).max(x[a] - Array4r::Map(node.max[a].data()))
+				.max(real(0)).eval();
+			d += e * e;
+		}
+
+		// Order the children by distance.
+		int order[4] = {0, 1, 2, 3};
+		for (auto i = 1; i < 4; ++i)
+			for (auto j = i; j > 0 && d[order[j]] < d[order[j - 1]]; --j)
+				std::swap(order[j], order[j - 1]);
+
+		for (auto i = 0; i < 4; ++i)
+		{
+			auto c = order[i];
+			if (node.counts[c] > 0 && d[c] < sq_dist)
+			{
+				for (auto e = node.children[c]; e < node.children[c] + node.counts[c]; ++e)
+					cb(m_lst[e]);
+			}
+		}
+		for (auto i = 3; i >= 0; --i)
+		{
+			auto c = order[i];
+			if (node.counts[c] == 0 && node.children[c] >= 0 && d[c] < sq_dist)
+				pending[n_pending++] = { node.children[c], d[c] };
+		}
+	}
+}
+
+}
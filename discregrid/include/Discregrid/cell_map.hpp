@@ -0,0 +1,147 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <streambuf>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Discregrid
+{
+
+// Read-only view of a cell map whose data is held elsewhere, e.g. by a CellMap
+// or in a memory-mapped file. See CellMap for the representation.
+class CellMapView
+{
+public:
+
+	CellMapView() = default;
+
+	// Identity for a grid of the given resolution.
+	explicit CellMapView(Eigen::Vector3i const& resolution)
+		: m_resolution(resolution)
+	{
+	}
+
+	// Compact map given by the occupancy masks of the blocks, the block offsets
+	// into the list of stored cell indices and this list.
+	CellMapView(Eigen::Vector3i const& resolution, uint64_t const* masks,
+		int const* offsets, int const* cells)
+		: m_identity(false), m_resolution(resolution), m_n_blocks((resolution.array() + 3) / 4),
+		m_masks(masks), m_offsets(offsets), m_cells(cells)
+	{
+	}
+
+	int operator[](int l) const
+	{
+		if (m_identity)
+			return l;
+
+		auto i = l % m_resolution[0];
+		auto jk = l / m_resolution[0];
+		auto j = jk % m_resolution[1];
+		auto k = jk / m_resolution[1];
+
+		auto b = (m_n_blocks[1] * (k >> 2) + (j >> 2)) * m_n_blocks[0] + (i >> 2);
+		auto bit = ((k & 3) << 4) | ((j & 3) << 2) | (i & 3);
+		auto mask = m_masks[b];
+		if (!((mask >> bit) & 1u))
+			return std::numeric_limits<int>::max();
+		return m_cells[m_offsets[b] + popcount(mask & ((uint64_t{1} << bit) - 1u))];
+	}
+
+	bool isIdentity() const { return m_identity; }
+	Eigen::Vector3i const& resolution() const { return m_resolution; }
+
+	// Number of blocks and data of the compact representation.
+	int nBlocks() const { return m_n_blocks.prod(); }
+	uint64_t const* masks() const { return m_masks; }
+	int const* offsets() const { return m_offsets; }
+	int const* cells() const { return m_cells; }
+
+	static int popcount(uint64_t x)
+	{
+#ifdef _MSC_VER
+		return static_cast<int>(__popcnt64(x));
+#else
+		return __builtin_popcountll(x);
+#endif
+	}
+
+private:
+
+	bool m_identity = true;
+	Eigen::Vector3i m_resolution = Eigen::Vector3i::Zero();
+	Eigen::Vector3i m_n_blocks = Eigen::Vector3i::Zero();
+	uint64_t const* m_masks = nullptr;
+	int const* m_offsets = nullptr;
+	int const* m_cells = nullptr;
+};
+
+// Maps the cells of a grid to the cells stored for one of its discretizations,
+// where removed cells are mapped to std::numeric_limits<int>::max(). Fields that
+// have not been reduced use the identity. For reduced fields the grid is divided
+// into blocks of 4x4x4 cells. Each block holds an occupancy mask and the position
+// of its first remaining cell in a list of stored cell indices, such that lookups
+// take constant time while the memory scales with the number of remaining cells.
+class CellMap
+{
+public:
+
+	CellMap() = default;
+
+	// Identity for a grid of the given resolution.
+	explicit CellMap(Eigen::Vector3i const& resolution);
+
+	// Compact representation of a map holding one entry per cell of the grid.
+	CellMap(Eigen::Vector3i const& resolution, std::vector<int> const& cell_map);
+
+	// Maps the cells l with keep_cell[l] != 0 in their order to 0, 1, 2, ... and
+	// all other cells to std::numeric_limits<int>::max().
+	CellMap(Eigen::Vector3i const& resolution, std::vector<char> const& keep_cell);
+
+	// Copy of the map referenced by view.
+	explicit CellMap(CellMapView const& view);
+
+	int operator[](int l) const
+	{
+		return view()[l];
+	}
+
+	CellMapView view() const
+	{
+		if (m_identity)
+			return CellMapView(m_resolution);
+		return CellMapView(m_resolution, m_masks.data(), m_offsets.data(), m_cells.data());
+	}
+
+	bool isIdentity() const { return m_identity; }
+	std::size_t size() const { return static_cast<std::size_t>(m_resolution.prod()); }
+
+	// Returns the map with one entry per cell of the grid.
+	std::vector<int> toDense() const;
+
+	bool write(std::streambuf& buf) const;
+	bool read(std::streambuf& buf);
+
+private:
+
+	// Determines the occupancy masks and the block offsets of the cells for which
+	// is_kept holds.
+	template <typename Predicate>
+	void buildBlocks(Predicate const& is_kept);
+
+	bool m_identity = true;
+	Eigen::Vector3i m_resolution = Eigen::Vector3i::Zero();
+	Eigen::Vector3i m_n_blocks = Eigen::Vector3i::Zero();
+	std::vector<uint64_t> m_masks;
+	std::vector<int> m_offsets;
+	std::vector<int> m_cells;
+};
+
+}
@@ -1,28 +1,255 @@
 #pragma once
 
 #include "discrete_grid.hpp"
+#include "cell_map.hpp"
+#include "acceleration/min_max_pyramid.hpp"
 #include "mesh/triangle_mesh.hpp"
+#include "utility/async_task.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace Discregrid
 {
 
+class MeshDistance;
+
 class CubicLagrangeDiscreteGrid : public DiscreteGrid
 {
 public:
 
     CubicLagrangeDiscreteGrid() : DiscreteGrid() {}
 	CubicLagrangeDiscreteGrid(std::string const& filename);
+	CubicLagrangeDiscreteGrid(std::string const& filename, std::vector<bool> const& field_mask);
 	CubicLagrangeDiscreteGrid(AlignedBox3r const& domain,
 		Eigen::Vector3i const& resolution);
 	CubicLagrangeDiscreteGrid(AlignedBox3r const& minimum_domain,
 							  Vector3r const& cell_size);
 
+	// Legacy is the stream format read by all versions of this library. Mappable is
+	// a versioned format with a field directory and checksummed sections, whose
+	// files can additionally be accessed in place by a MappedCubicLagrangeDiscreteGrid.
+	// Compressed uses the layout of Mappable but compresses each array losslessly,
+	// such that the file can only be loaded. load detects the format of a file.
+	enum class FileFormat
+	{
+		Legacy,
+		Mappable,
+		Compressed
+	};
+
+	// Parses the name of a file format, i.e. legacy, mappable or compressed. Returns
+	// false if the name is unknown.
+	static bool parseFileFormat(std::string const& name, FileFormat& format);
+
+	// Saves the grid in the format FileFormat::Legacy, which all versions of the
+	// library can read. The other formats are selected explicitly.
 	void save(std::string const& filename) const override;
+	void save(std::string const& filename, FileFormat format) const;
 	void load(std::string const& filename) override;
 
+	/**
+	 * @brief Loads a grid file, where only the fields selected by field_mask are read immediately.
+	 *
+	 * All other fields, including those beyond the size of the mask, are read from the file when
+	 * they are accessed for the first time, e.g. by interpolate, such that the I/O for fields that
+	 * are never used is skipped. Loading on first use is thread-safe. The file must not be modified
+	 * until all fields have been read or another file is loaded.
+	 *
+	 * @param filename Grid file in any of the formats of FileFormat
+	 * @param field_mask Flag per discretization ID whether the field is read immediately
+	 */
+	void load(std::string const& filename, std::vector<bool> const& field_mask);
+
+	// Serializes the grid into or deserializes it from a stream at its current
+	// position, e.g. to embed grids in archives. Loading leaves the stream
+	// positioned after the grid.
+	void save(std::streambuf& buf, FileFormat format = FileFormat::Mappable) const;
+	void save(std::ostream& out, FileFormat format = FileFormat::Mappable) const;
+	void load(std::streambuf& buf);
+	void load(std::istream& in);
+
+	// Loads a grid that resides in memory in any of the formats of FileFormat. The
+	// arrays are parsed in place, i.e. copied or decompressed directly from the
+	// buffer, which is not accessed after the function returns.
+	void loadFromMemory(void const* data, std::size_t size);
+
+	/**
+	 * @brief Loads a grid file on a thread of the given executor, e.g. to stream grids in the background.
+	 *
+	 * All fields are read before the grid becomes ready. Until then, queries are rejected, i.e.
+	 * interpolate returns std::numeric_limits<real>::max() and determineShapeFunctions returns
+	 * false. If the task fails or is cancelled, the grid keeps its previous data. The grid must
+	 * neither be modified nor destroyed until the task has finished.
+	 *
+	 * @param filename Grid file in any of the formats of FileFormat
+	 * @param executor Runs the task, which reports its progress and checks for cancellation
+	 * @return Handle of the task, whose result is the success of the function
+	 */
+	AsyncTask<bool> loadAsync(std::string const& filename, Executor const& executor);
+
 	int addFunction(ContinuousFunction const& func, bool verbose = false,
 		SamplePredicate const& pred = nullptr) override;
 
+	/**
+	 * @brief Discretizes func on a thread of the given executor, see addFunction.
+	 *
+	 * The function is evaluated in parallel by the OpenMP threads of the executing thread. Queries
+	 * of all fields are rejected until the task has finished, see loadAsync.
+	 *
+	 * @param func Function to be discretized
+	 * @param executor Runs the task, which reports its progress and checks for cancellation
+	 * @param pred (Optional) nodes for which pred is false are assigned std::numeric_limits<real>::max()
+	 * @return Handle of the task, whose result is the ID of the new discretization or -1
+	 */
+	AsyncTask<int> addFunctionAsync(ContinuousFunction const& func, Executor const& executor,
+		SamplePredicate const& pred = nullptr);
+
+	// Whether no asynchronous task is running on the grid, see loadAsync.
+	bool isReady() const { return !m_task || m_task->isReady(); }
+
+	using CellPredicate = std::function<bool(AlignedBox3r const&)>;
+
+	/**
+	 * @brief Discretizes func only on the cells whose domain fulfills keep_cell.
+	 *
+	 * The field is directly constructed in the sparse layout produced by reduceField, i.e. only
+	 * the nodes of the remaining cells are stored and sorted along a z-curve, without allocating
+	 * the coefficients and cells of the full grid first. The predicate is evaluated concurrently
+	 * and therefore has to be thread-safe.
+	 *
+	 * @param func Function to be discretized
+	 * @param keep_cell Predicate deciding for the domain of a cell whether the cell is kept
+	 * @param verbose Prints the construction time
+	 * @return ID of the new discretization
+	 */
+	int addSparseFunction(ContinuousFunction const& func, CellPredicate const& keep_cell,
+		bool verbose = false);
+
+	/**
+	 * @brief Discretizes the signed distance to a triangle mesh in a narrow band around its surface.
+	 *
+	 * Instead of querying the distance at every node, each triangle is scan converted into the
+	 * nodes within band_width around it and the closest triangle per node is determined by a
+	 * min-reduction. Nodes further away from the surface than band_width are assigned
+	 * std::numeric_limits<real>::max() and can subsequently be discarded using reduceField.
+	 *
+	 * @param md Distance structure of a closed two-manifold triangle mesh
+	 * @param band_width Maximum unsigned distance of a discretized node to the surface
+	 * @param verbose Prints the construction time
+	 * @return ID of the new discretization
+	 */
+	int addNarrowBandDistance(MeshDistance const& md, real band_width, bool verbose = false);
+
+	/**
+	 * @brief Discretizes func on this grid and streams the result into a file without holding it in memory.
+	 *
+	 * The field is evaluated in slabs whose size is bounded by slab_budget, such that grids can be
+	 * constructed that do not fit into memory as a whole. If a predicate is given, each slab is
+	 * reduced on the fly with the semantics of reduceField, except that the remaining nodes are
+	 * numbered in the order of the slabs instead of being sorted along a z-curve. The resulting file
+	 * holds the geometry of this grid and the new field only; the grid itself is not modified.
+	 *
+	 * @param filename Output file that can be read using load
+	 * @param func Function to be discretized
+	 * @param slab_budget Maximum number of bytes occupied by the data of a slab
+	 * @param pred (Optional) if given, nodes for which pred is false are discarded as in reduceField
+	 * @param verbose Prints the construction progress
+	 * @return Success of the function.
+	 */
+	bool streamFunction(std::string const& filename, ContinuousFunction const& func,
+		std::size_t slab_budget, Predicate const& pred = nullptr, bool verbose = false) const;
+
+	/**
+	 * @brief Creates an empty grid covering the cells [cell_begin, cell_end) of this grid.
+	 *
+	 * Fields can be added to such a shard independently of the other shards of the grid, e.g. in
+	 * separate processes, and the saved shards can subsequently be stitched together using merge.
+	 *
+	 * @param cell_begin Multi-index of the first cell covered by the shard
+	 * @param cell_end Multi-index past the last cell covered by the shard
+	 * @return Shard of this grid without any fields
+	 */
+	CubicLagrangeDiscreteGrid shard(MultiIndex const& cell_begin, MultiIndex const& cell_end) const;
+
+	/**
+	 * @brief Replaces this grid by the union of the given shard files.
+	 *
+	 * The shards must share the cell size and a common cell lattice and have to hold the same number
+	 * of fields. The domain of the result is the bounding box of the shard domains. Nodes on faces
+	 * shared by several shards are stored only once, where the value of the last shard is taken.
+	 * Cells that are not covered by any shard or that were removed from a shard are removed from
+	 * the merged fields.
+	 *
+	 * @param shard_filenames Files of the shards, e.g. generated using shard and save
+	 * @param verbose Prints the merge progress
+	 * @return Success of the function.
+	 */
+	bool merge(std::vector<std::string> const& shard_filenames, bool verbose = false);
+
+	/**
+	 * @brief Creates a new grid holding all fields of this grid resampled onto the given domain and resolution.
+	 *
+	 * The coefficients of the new grid are obtained by evaluating the cubic interpolant of this
+	 * grid at the new nodes, e.g. to derive a coarser level of detail or to crop the domain
+	 * without the source geometry. The new nodes are grouped by the cell of this grid they fall
+	 * into, such that the cell data is gathered once per cell and the shape functions are
+	 * evaluated once per node for all fields. Nodes outside of the domain or of the remaining
+	 * cells of a reduced field are assigned std::numeric_limits<real>::max(); fields that were
+	 * reduced are reduced accordingly in the new grid.
+	 *
+	 * @param target_domain Domain of the new grid
+	 * @param target_resolution Resolution of the new grid
+	 * @param verbose Prints the construction time
+	 * @return New grid with the same number of fields as this grid
+	 */
+	CubicLagrangeDiscreteGrid resample(AlignedBox3r const& target_domain,
+		Eigen::Vector3i const& target_resolution, bool verbose = false) const;
+
+	using CombineFunction = std::function<real(real, real)>;
+
+	/**
+	 * @brief Creates a new grid whose only field combines field field_a of a and field field_b of b node-wise.
+	 *
+	 * If both grids share domain and resolution, op is directly applied to the node coefficients.
+	 * Otherwise both fields are first resampled onto a grid covering both domains with the smaller
+	 * cell size of the two grids. Where only one of the fields is defined, op is passed
+	 * std::numeric_limits<real>::max() for the other one. The new field is reduced if one of the
+	 * operands was reduced.
+	 *
+	 * @param a Grid holding the first operand
+	 * @param field_a Discretization ID of the first operand
+	 * @param b Grid holding the second operand
+	 * @param field_b Discretization ID of the second operand
+	 * @param op Function combining the values of both operands
+	 * @param verbose Prints the construction time
+	 * @return New grid holding the combined field
+	 */
+	static CubicLagrangeDiscreteGrid combine(CubicLagrangeDiscreteGrid const& a, int field_a,
+		CubicLagrangeDiscreteGrid const& b, int field_b, CombineFunction const& op, bool verbose = false);
+
+	// Boolean operations on signed distance fields, see combine. The smooth union
+	// blends both surfaces within the distance k of each other.
+	static CubicLagrangeDiscreteGrid csgUnion(CubicLagrangeDiscreteGrid const& a,
+		CubicLagrangeDiscreteGrid const& b, int field_a = 0, int field_b = 0);
+	static CubicLagrangeDiscreteGrid csgIntersection(CubicLagrangeDiscreteGrid const& a,
+		CubicLagrangeDiscreteGrid const& b, int field_a = 0, int field_b = 0);
+	static CubicLagrangeDiscreteGrid csgDifference(CubicLagrangeDiscreteGrid const& a,
+		CubicLagrangeDiscreteGrid const& b, int field_a = 0, int field_b = 0);
+	static CubicLagrangeDiscreteGrid csgSmoothUnion(CubicLagrangeDiscreteGrid const& a,
+		CubicLagrangeDiscreteGrid const& b, real k, int field_a = 0, int field_b = 0);
+
+	/**
+	 * @brief Offsets the level sets of the discretization with ID field_id.
+	 *
+	 * The distance is subtracted from all coefficients, i.e. for a signed distance field a
+	 * positive distance dilates and a negative distance erodes the surface.
+	 *
+	 * @param field_id Discretization ID
+	 * @param distance Offset distance
+	 */
+	void offsetField(int field_id, real distance);
 
 	std::size_t nCells() const { return m_n_cells; };
 	real interpolate(int field_id, Vector3r const& xi,
@@ -58,22 +285,234 @@ public:
 	real interpolate(int field_id, Vector3r const& xi, const std::array<int, 32> &cell, const Vector3r &c0, const Eigen::Matrix<real, 32, 1> &N,
 		Vector3r* gradient = nullptr, Eigen::Matrix<real, 32, 3> *dN = nullptr) const override;
 
+	/**
+	 * @brief Removes all cells of the discretization with ID field_id that do not contain a node for which pred holds.
+	 *
+	 * The remaining nodes are sorted along a z-curve. The predicate is evaluated concurrently for
+	 * all nodes and therefore has to be thread-safe. Fields that were reduced before are reduced
+	 * further.
+	 *
+	 * @param field_id Discretization ID
+	 * @param pred Predicate on the location and the value of a node
+	 */
 	void reduceField(int field_id, Predicate pred) override;
 
 	void forEachCell(std::function<void(int, AlignedBox3r const&, int)> const& cb) const;
 
-	TriangleMesh marchingCubes(real isoLevel);
+	/**
+	 * @brief Extracts the iso-surface of a field by marching cubes.
+	 *
+	 * Each cell is polygonized on a lattice of subdivision^3 sub-cells, whose corner values are
+	 * given by the cubic interpolant of the cell, such that high quality meshes are extracted
+	 * from grids of low resolution. Cells with undefined coefficients and cells removed by
+	 * reduceField are skipped. Each edge of the sub-cells intersected by the surface is assigned
+	 * a single vertex, such that the mesh is closed unless the surface leaves the domain or the
+	 * defined cells. The mesh does not depend on the number of threads, i.e. vertices and
+	 * triangles are ordered by the cells they belong to.
+	 *
+	 * @param field_id Index of the field
+	 * @param isoLevel Value of the iso-surface
+	 * @param subdivision Number of sub-cells per cell along each axis
+	 * @param pyramid (Optional) pyramid of the field, see minMaxPyramid
+	 * @return Indexed triangle mesh of the iso-surface
+	 */
+	TriangleMesh marchingCubes(int field_id, real isoLevel, int subdivision = 1,
+		MinMaxPyramid const* pyramid = nullptr);
+
+	// Extracts the iso-surface of field 0 without subdivision.
+	TriangleMesh marchingCubes(real isoLevel) { return marchingCubes(0, isoLevel); }
+
+	/**
+	 * @brief Extracts the iso-surfaces of several iso-levels of a field in a single pass.
+	 *
+	 * Each cell is loaded and its sub-cell lattice evaluated once for all levels, which are then
+	 * classified and polygonized separately, such that the time grows slower than the number of
+	 * levels. Each mesh is identical to the one returned by marchingCubes for its level.
+	 *
+	 * @param field_id Index of the field
+	 * @param isoLevels Values of the iso-surfaces
+	 * @param subdivision Number of sub-cells per cell along each axis
+	 * @param pyramid (Optional) pyramid of the field, see minMaxPyramid
+	 * @return Indexed triangle mesh of each iso-surface in the order of isoLevels
+	 */
+	std::vector<TriangleMesh> marchingCubes(int field_id, std::vector<real> const& isoLevels,
+		int subdivision = 1, MinMaxPyramid const* pyramid = nullptr);
+
+	/**
+	 * @brief Extracts the iso-surface of a field by marching cubes and streams it into a file.
+	 *
+	 * The mesh is written layer by layer of cells while it is extracted, such that only the vertices
+	 * and triangles of one layer are held in memory and no TriangleMesh is constructed. The text of
+	 * OBJ files is formatted in parallel. The written mesh is identical to the one returned by
+	 * marchingCubes.
+	 *
+	 * @param filename Output file
+	 * @param format Format of the output file, where PLY files are binary
+	 * @param field_id Index of the field
+	 * @param isoLevel Value of the iso-surface
+	 * @param subdivision Number of sub-cells per cell along each axis
+	 * @param pyramid (Optional) pyramid of the field, see minMaxPyramid
+	 * @return Success of the function.
+	 */
+	bool streamMarchingCubes(std::string const& filename, MeshFileFormat format, int field_id,
+		real isoLevel, int subdivision = 1, MinMaxPyramid const* pyramid = nullptr);
+
+	/**
+	 * @brief Extracts the iso-surface of a field by dual contouring.
+	 *
+	 * The cells are subdivided as for marchingCubes, but instead of placing vertices on the
+	 * intersected edges, each intersected sub-cell is assigned a single vertex. The vertex
+	 * minimizes the squared distances to the tangent planes at the intersections of the edges of
+	 * the sub-cell, whose normals are given by the gradient of the interpolant. Each intersected
+	 * edge yields a quad connecting the vertices of the four sub-cells around it, which is split
+	 * into two triangles. As the vertices are not restricted to the edges, sharp features are
+	 * preserved and a given accuracy is reached with a lower subdivision than by marchingCubes,
+	 * i.e. with considerably fewer triangles. The mesh may be non-manifold where the surface
+	 * passes a sub-cell more than once.
+	 *
+	 * @param field_id Index of the field
+	 * @param isoLevel Value of the iso-surface
+	 * @param subdivision Number of sub-cells per cell along each axis
+	 * @param pyramid (Optional) pyramid of the field, see minMaxPyramid
+	 * @return Indexed triangle mesh of the iso-surface
+	 */
+	TriangleMesh dualContouring(int field_id, real isoLevel, int subdivision = 1,
+		MinMaxPyramid const* pyramid = nullptr);
+
+	/**
+	 * @brief Bounds the coefficients of a field over blocks of cells.
+	 *
+	 * Passing the pyramid to marchingCubes restricts the extraction to the blocks that may contain
+	 * the iso-level, such that the cost of an extraction is governed by the size of the surface
+	 * rather than by the size of the grid. A pyramid can be reused for any iso-level and
+	 * subdivision but has to be rebuilt when the field is modified.
+	 *
+	 * @param field_id Index of the field
+	 * @return Min/max pyramid of the field
+	 */
+	MinMaxPyramid minMaxPyramid(int field_id) const;
 
 private:
 
+	void saveLegacy(std::streambuf& buf) const;
+	void saveSectioned(std::streambuf& buf, bool compressed) const;
+	// Loads the fields i with field_mask[i] immediately and all others on first
+	// use. All fields are loaded immediately if no mask is given.
+	void loadFields(std::string const& filename, std::vector<bool> const* field_mask);
+	// Reads a grid in the legacy format following its domain from buf. The file
+	// is only required to read pending fields if a mask is given.
+	bool loadLegacy(std::streambuf& buf, std::string const& filename, std::vector<bool> const* field_mask);
+	// Reads a grid in the sectioned format from memory, which is kept alive by
+	// owner for reading pending fields if a mask is given.
+	bool loadSectioned(char const* data, std::size_t size, std::shared_ptr<void const> const& owner,
+		std::vector<bool> const* field_mask);
+	// Reads a grid in any of the formats of FileFormat from memory.
+	bool loadBuffer(char const* data, std::size_t size);
+
+	// Reads the given field from the loaded file if it has not been read yet.
+	void requireField(int field_id) const
+	{
+		if (m_pending_fields.isPending(field_id))
+			loadPendingField(field_id);
+	}
+	void requireAllFields() const;
+	void loadPendingField(int field_id) const;
+
 	Vector3r indexToNodePosition(int l) const;
 
+	// Creates the cells and the cell map of the field whose coefficients were
+	// added last for all nodes. Returns the ID of the field.
+	int finalizeDenseField();
+
+	// Returns the nodes of cell l of a field that has not been reduced.
+	std::array<int, 32> denseCell(int l) const;
+
+	// The cells of fields that have not been reduced are implied by the grid, see
+	// denseCell, and are not stored. Fields that were reduced or whose nodes were
+	// reordered hold their cells explicitly.
+	bool hasImplicitCells(int field_id) const
+	{
+		return m_cells[field_id].empty() && m_cell_map[field_id].isIdentity();
+	}
+
+	// Returns the nodes of cell c of field field_id, where c is numbered by the
+	// cell map of the field.
+	std::array<int, 32> fieldCell(int field_id, int c) const
+	{
+		return m_cells[field_id].empty() ? denseCell(c) : m_cells[field_id][c];
+	}
+
+	// Number of cells of field field_id, which is less than nCells() if the field
+	// was reduced.
+	std::size_t nFieldCells(int field_id) const
+	{
+		return hasImplicitCells(field_id) ? m_n_cells : m_cells[field_id].size();
+	}
+
+	// Releases the explicit cells of field field_id if they are implied by the grid.
+	void releaseDenseCells(int field_id);
+
+	// Returns the coefficients of field field_id for the full set of nodes of the
+	// grid, where nodes that do not belong to the field are assigned
+	// std::numeric_limits<real>::max().
+	std::vector<real> denseNodes(int field_id) const;
+
+	// Resamples the fields field_ids only, see the public overload.
+	CubicLagrangeDiscreteGrid resample(AlignedBox3r const& target_domain,
+		Eigen::Vector3i const& target_resolution, std::vector<int> const& field_ids, bool verbose) const;
+
+	// Returns the index of each node of field field_id in the dense field, or an
+	// empty list if the nodes are numbered as in the dense field.
+	std::vector<int> denseNodeIndices(int field_id) const;
+
+	// Removes the cells l of field field_id for which keep_cell[l] is zero together
+	// with all nodes that are not referenced by the remaining cells and sorts the
+	// remaining nodes along a z-curve. keep_cell must be zero for cells the field
+	// does not hold, and dense_nodes is given by denseNodeIndices; its cells are rebuilt.
+	void removeCells(int field_id, std::vector<char> const& keep_cell,
+		std::vector<int> const& dense_nodes);
+
+	// Nodes lie on a lattice with a third of the cell size as spacing. A lattice
+	// point ijk is a node if at most one of its coordinates is not divisible by 3.
+	int latticeToNodeIndex(MultiIndex const& ijk) const;
+	Vector3r latticeToNodePosition(MultiIndex const& ijk) const;
+
 
 private:
 
 	std::vector<std::vector<real>> m_nodes;
 	std::vector<std::vector<std::array<int, 32>>> m_cells;
-	std::vector<std::vector<int>> m_cell_map;
+	std::vector<CellMap> m_cell_map;
+
+	// Reads the coefficients, cells and cell map of a field from the loaded file.
+	using FieldReader = std::function<bool(int, std::vector<real>&, std::vector<std::array<int, 32>>&, CellMap&)>;
+
+	// Fields of the loaded file that are read on first use, see load.
+	struct PendingFields
+	{
+		PendingFields() = default;
+		PendingFields(PendingFields const& other);
+		PendingFields& operator=(PendingFields const& other);
+
+		bool isPending(int field_id) const
+		{
+			return static_cast<std::size_t>(field_id) < n_fields &&
+				pending[field_id].load(std::memory_order_acquire);
+		}
+
+		FieldReader reader;
+		std::size_t n_fields = 0u;
+		std::size_t n_pending = 0u;
+		std::unique_ptr<std::atomic<bool>[]> pending;
+		std::unique_ptr<std::mutex> mutex = std::unique_ptr<std::mutex>(new std::mutex);
+	};
+
+	void setPendingFields(FieldReader const& reader, std::vector<bool> const& pending);
+
+	mutable PendingFields m_pending_fields;
+
+	// Task that was last started on the grid, see loadAsync.
+	std::shared_ptr<AsyncTaskState> m_task;
 };
 
 }
\ No newline at end of file
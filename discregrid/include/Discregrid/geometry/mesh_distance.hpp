@@ -35,6 +35,7 @@ namespace std {
 #include <Discregrid/utility/lru_cache.hpp>
 
 #include <Discregrid/acceleration/bounding_sphere_hierarchy.hpp>
+#include <Discregrid/acceleration/wide_bounding_box_hierarchy.hpp>
 
 
 #include <array>
@@ -62,7 +63,19 @@ class MeshDistance
 	};
 
 public:
-	MeshDistance(const TriangleMesh* mesh, bool precompute_normals = true);
+
+	// Bounding volume hierarchy accelerating the closest point queries.
+	enum class Hierarchy
+	{
+		// Binary hierarchy of bounding spheres split at the median.
+		BoundingSpheres,
+		// Hierarchy of axis-aligned boxes with four children per node built by the
+		// surface area heuristic, see TriangleMeshWideBBH.
+		WideBoxes
+	};
+
+	MeshDistance(const TriangleMesh* mesh, bool precompute_normals = true,
+		Hierarchy hierarchy = Hierarchy::BoundingSpheres);
 
 	// Returns the shortest unsigned distance from a given point x to
 	// the stored mesh.
@@ -77,8 +90,17 @@ public:
 
 	real unsignedDistance(Vector3r const& x) const;
 
+	// Returns the distance from x to the face f. The sign is determined by
+	// the pseudonormal of the feature of f that is closest to x.
+	// Thread-safe function.
+	real signedFaceDistance(Vector3r const& x, int f) const;
+
+	TriangleMesh const* mesh() const { return m_mesh; }
+
 private:
 
+	Vector3r pseudo_normal(int f, NearestEntity ne) const;
+
 	Vector3r vertex_normal(int v) const;
 	Vector3r edge_normal(Halfedge const& h) const;
 	Vector3r face_normal(int f) const;
@@ -93,7 +115,9 @@ private:
 private:
 
 	const TriangleMesh* m_mesh;
+	Hierarchy m_hierarchy;
 	TriangleMeshBSH m_bsh;
+	TriangleMeshWideBBH m_wbbh;
 
 	using FunctionValueCache = LRUCache<Vector3r, real>;
 
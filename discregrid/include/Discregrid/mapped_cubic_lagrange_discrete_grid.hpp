@@ -0,0 +1,87 @@
+#pragma once
+
+#include "discrete_grid.hpp"
+#include "cell_map.hpp"
+
+#include <span.hpp>
+
+namespace Discregrid
+{
+
+/**
+ * @brief Read-only cubic Lagrange discretization mapped from a file.
+ *
+ * The file has to be saved by a CubicLagrangeDiscreteGrid in the format FileFormat::Mappable.
+ * Loading only maps the file into memory and validates its layout; the coefficients and cells
+ * are neither parsed nor copied and are interpolated directly on the mapped pages. Hence, only
+ * the pages touched by queries are read from disk and all processes mapping the same file
+ * share a single copy in the page cache. For the same reason only the checksum of the field
+ * directory is verified when the file is mapped; the sections can be verified on demand.
+ */
+class MappedCubicLagrangeDiscreteGrid : public DiscreteGrid
+{
+public:
+
+	MappedCubicLagrangeDiscreteGrid() = default;
+	MappedCubicLagrangeDiscreteGrid(std::string const& filename);
+	MappedCubicLagrangeDiscreteGrid(MappedCubicLagrangeDiscreteGrid&& other);
+	MappedCubicLagrangeDiscreteGrid& operator=(MappedCubicLagrangeDiscreteGrid&& other);
+	MappedCubicLagrangeDiscreteGrid(MappedCubicLagrangeDiscreteGrid const&) = delete;
+	MappedCubicLagrangeDiscreteGrid& operator=(MappedCubicLagrangeDiscreteGrid const&) = delete;
+	~MappedCubicLagrangeDiscreteGrid() override;
+
+	// Writes a copy of the mapped file.
+	void save(std::string const& filename) const override;
+	// Maps the given file and releases a previously mapped one.
+	void load(std::string const& filename) override;
+	// Accesses a grid in the mappable format that already resides in memory, e.g.
+	// in the buffer of an archive, without copying it. The buffer has to be aligned
+	// to 8 bytes and must outlive the use of the grid.
+	void loadFromMemory(void const* data, std::size_t size);
+
+	// The mapped fields are read-only, hence no function can be added. Returns -1.
+	int addFunction(ContinuousFunction const& func, bool verbose = false,
+		SamplePredicate const& pred = nullptr) override;
+
+	bool isMapped() const { return m_data != nullptr; }
+	std::size_t nCells() const { return m_n_cells; }
+	std::size_t nFields() const { return m_fields.size(); }
+
+	// Verifies the checksums of all sections of the mapped file, which reads the whole file.
+	bool verifyChecksums() const;
+
+	// Mapped data of the discretization with ID field_id, see CubicLagrangeDiscreteGrid.
+	// The cells of fields that were not reduced are not stored and hence empty.
+	std::span<real const> nodes(int field_id) const { return m_fields[field_id].nodes; }
+	std::span<std::array<int, 32> const> cells(int field_id) const { return m_fields[field_id].cells; }
+	CellMapView const& cellMap(int field_id) const { return m_fields[field_id].cell_map; }
+
+	real interpolate(int field_id, Vector3r const& xi,
+		Vector3r* gradient = nullptr) const override;
+
+	bool determineShapeFunctions(int field_id, Vector3r const &x,
+		std::array<int, 32> &cell, Vector3r &c0, Eigen::Matrix<real, 32, 1> &N,
+		Eigen::Matrix<real, 32, 3> *dN = nullptr) const override;
+
+	real interpolate(int field_id, Vector3r const& xi, const std::array<int, 32> &cell, const Vector3r &c0, const Eigen::Matrix<real, 32, 1> &N,
+		Vector3r* gradient = nullptr, Eigen::Matrix<real, 32, 3> *dN = nullptr) const override;
+
+private:
+
+	void attach(char const* data, std::size_t size, bool owns_data);
+	void unmap();
+
+	struct Field
+	{
+		std::span<real const> nodes;
+		std::span<std::array<int, 32> const> cells;
+		CellMapView cell_map;
+	};
+
+	char const* m_data = nullptr;
+	std::size_t m_size = 0u;
+	bool m_owns_data = false;
+	std::vector<Field> m_fields;
+};
+
+}
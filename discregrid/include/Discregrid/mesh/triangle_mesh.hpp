@@ -14,6 +14,13 @@
 namespace Discregrid
 {
 
+// File formats for writing triangle meshes, where PLY files are binary.
+enum class MeshFileFormat
+{
+	OBJ,
+	PLY
+};
+
 class TriangleMesh
 {
 
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "../types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Discregrid
+{
+
+// Runs a task on a thread chosen by the caller, e.g. by submitting it to a
+// thread pool. Each task passed to an executor has to be invoked exactly once.
+using Executor = std::function<void(std::function<void()>)>;
+
+enum class TaskStatus
+{
+	Running,
+	Done,
+	Cancelled,
+	Failed
+};
+
+// State of an asynchronous operation that is shared between its handles and
+// the thread executing it.
+class AsyncTaskState
+{
+public:
+
+	using ProgressCallback = std::function<void(real)>;
+
+	TaskStatus status() const { return m_status.load(std::memory_order_acquire); }
+	bool isReady() const { return status() != TaskStatus::Running; }
+	real progress() const { return m_progress.load(std::memory_order_relaxed); }
+
+	// Cancellation is cooperative, i.e. the operation stops at its next check.
+	void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+	bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+	void wait() const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_completed.wait(lock, [this]() { return isReady(); });
+	}
+
+	template <typename Rep, typename Period>
+	bool waitFor(std::chrono::duration<Rep, Period> const& timeout) const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		return m_completed.wait_for(lock, timeout, [this]() { return isReady(); });
+	}
+
+	// The callback is invoked by the executing thread whenever the progress has
+	// advanced by at least a percent.
+	void onProgress(ProgressCallback const& callback)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_progress_callbacks.push_back(callback);
+	}
+
+	// Called by the executing thread, possibly concurrently, with the fraction of
+	// the operation that has been completed.
+	void setProgress(real progress)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (progress < m_reported_progress + static_cast<real>(0.01) &&
+			!(progress >= static_cast<real>(1.0) && m_reported_progress < static_cast<real>(1.0)))
+			return;
+		m_reported_progress = progress;
+		m_progress.store(progress, std::memory_order_relaxed);
+		for (auto const& callback : m_progress_callbacks)
+			callback(progress);
+	}
+
+protected:
+
+	// Publishes the status, where update stores the result under the lock.
+	template <typename Update>
+	void complete(TaskStatus status, Update const& update)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		update();
+		m_status.store(status, std::memory_order_release);
+		m_progress_callbacks.clear();
+		m_completed.notify_all();
+	}
+
+	mutable std::mutex m_mutex;
+
+private:
+
+	std::atomic<TaskStatus> m_status{TaskStatus::Running};
+	std::atomic<real> m_progress{0.0};
+	std::atomic<bool> m_cancelled{false};
+	real m_reported_progress = 0.0;
+	std::vector<ProgressCallback> m_progress_callbacks;
+	mutable std::condition_variable m_completed;
+};
+
+/**
+ * @brief Handle of an asynchronous operation with a result of type T.
+ *
+ * Handles are cheap to copy and share the state of the operation. Completion callbacks are
+ * invoked by the thread that finishes the operation, or immediately by the registering thread
+ * if the operation has already finished.
+ */
+template <typename T>
+class AsyncTask
+{
+public:
+
+	using CompletionCallback = std::function<void(TaskStatus, T const&)>;
+
+	class State : public AsyncTaskState
+	{
+	public:
+
+		State(T value) : m_value(std::move(value)) {}
+
+		T const& value() const { return m_value; }
+
+		void onCompletion(CompletionCallback const& callback)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!isReady())
+				{
+					m_callbacks.push_back(callback);
+					return;
+				}
+			}
+			callback(status(), m_value);
+		}
+
+		// Called once by the executing thread.
+		void finish(TaskStatus status, T value)
+		{
+			auto callbacks = std::vector<CompletionCallback>{};
+			complete(status, [&]()
+			{
+				m_value = std::move(value);
+				callbacks.swap(m_callbacks);
+			});
+			for (auto const& callback : callbacks)
+				callback(status, m_value);
+		}
+
+	private:
+
+		T m_value;
+		std::vector<CompletionCallback> m_callbacks;
+	};
+
+	AsyncTask() = default;
+	explicit AsyncTask(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+	// Creates the handle of an operation that is not executed, e.g. because its
+	// arguments are invalid.
+	static AsyncTask finished(TaskStatus status, T value)
+	{
+		auto state = std::make_shared<State>(value);
+		state->finish(status, std::move(value));
+		return AsyncTask(std::move(state));
+	}
+
+	bool valid() const { return m_state != nullptr; }
+	TaskStatus status() const { return m_state->status(); }
+	bool isReady() const { return m_state->isReady(); }
+	real progress() const { return m_state->progress(); }
+	void cancel() { m_state->cancel(); }
+	void wait() const { m_state->wait(); }
+
+	template <typename Rep, typename Period>
+	bool waitFor(std::chrono::duration<Rep, Period> const& timeout) const
+	{
+		return m_state->waitFor(timeout);
+	}
+
+	// Waits for the operation to finish and returns its result.
+	T const& get() const
+	{
+		m_state->wait();
+		return m_state->value();
+	}
+
+	void onProgress(AsyncTaskState::ProgressCallback const& callback) { m_state->onProgress(callback); }
+	void onCompletion(CompletionCallback const& callback) { m_state->onCompletion(callback); }
+
+	std::shared_ptr<State> const& state() const { return m_state; }
+
+private:
+
+	std::shared_ptr<State> m_state;
+};
+
+}
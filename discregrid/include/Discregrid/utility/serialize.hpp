@@ -1,6 +1,9 @@
 #pragma once
 
 #include <streambuf>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
 
 namespace Discregrid
 {
@@ -23,6 +26,45 @@ bool read(std::streambuf& buf, T& val)
 	auto bytes = sizeof(T);
 	return buf.sgetn(reinterpret_cast<char*>(&val), bytes) == bytes;
 }
+
+// Vectors of standard layout types are written as their size followed by their
+// contiguous data, which is transferred in large chunks.
+constexpr std::size_t chunk_bytes = std::size_t{1} << 26;
+
+template<class T>
+bool write(std::streambuf& buf, const std::vector<T>& val)
+{
+	static_assert( std::is_standard_layout<T>{}, "data is not standard layout" );
+	if (!write(buf, val.size()))
+		return false;
+	auto data = reinterpret_cast<const char*>(val.data());
+	auto bytes = val.size() * sizeof(T);
+	for (auto offset = std::size_t{0}; offset < bytes; offset += chunk_bytes)
+	{
+		auto n = static_cast<std::streamsize>(std::min(chunk_bytes, bytes - offset));
+		if (buf.sputn(data + offset, n) != n)
+			return false;
+	}
+	return true;
+}
+template<class T>
+bool read(std::streambuf& buf, std::vector<T>& val)
+{
+	static_assert( std::is_standard_layout<T>{}, "data is not standard layout" );
+	auto size = std::size_t{};
+	if (!read(buf, size))
+		return false;
+	val.resize(size);
+	auto data = reinterpret_cast<char*>(val.data());
+	auto bytes = val.size() * sizeof(T);
+	for (auto offset = std::size_t{0}; offset < bytes; offset += chunk_bytes)
+	{
+		auto n = static_cast<std::streamsize>(std::min(chunk_bytes, bytes - offset));
+		if (buf.sgetn(data + offset, n) != n)
+			return false;
+	}
+	return true;
+}
 }
 
 template<class T>
@@ -9,18 +9,35 @@ using namespace Eigen;
 namespace Discregrid
 {
 
+namespace
+{
+
+// Points of the hull computed last by each thread, such that the buffer is
+// only allocated when it grows.
+thread_local std::vector<Vector3r> hull_points;
+
+// The random permutation of the points of a hull only depends on the node.
+unsigned int
+hullSeed(int b, int n)
+{
+	return static_cast<unsigned int>(b) * 2654435761u ^ static_cast<unsigned int>(n);
+}
+
+}
+
 TriangleMeshBSH::TriangleMeshBSH(
         std::span<const Vector3r> vertices,
         std::span<const Eigen::Vector3i> faces)
 	: super(faces.size()), m_faces(faces), m_vertices(vertices),
 		m_tri_centers(faces.size())
 {
-	std::transform(m_faces.begin(), m_faces.end(), m_tri_centers.begin(),
-		[&](Vector3i const& f)
-		{
-			return 1.0 / 3.0 * (m_vertices[f[0]] + m_vertices[f[1]] +
-				m_vertices[f[2]]);
-		});
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < static_cast<int>(m_faces.size()); ++i)
+	{
+		auto const& f = m_faces[i];
+		m_tri_centers[i] = 1.0 / 3.0 * (m_vertices[f[0]] + m_vertices[f[1]] +
+			m_vertices[f[2]]);
+	}
 }
 
 Vector3r const&
@@ -32,7 +49,8 @@ TriangleMeshBSH::entityPosition(int i) const
 void
 TriangleMeshBSH::computeHull(int b, int n, BoundingSphere& hull) const
 {
-	auto vertices_subset = std::vector<Vector3r>(3 * n);
+	auto& vertices_subset = hull_points;
+	vertices_subset.resize(3 * n);
 	for (int i(0); i < n; ++i)
 	{
 		auto const& f = m_faces[m_lst[b + i]];
@@ -43,10 +61,14 @@ TriangleMeshBSH::computeHull(int b, int n, BoundingSphere& hull) const
 		}
 	}
 
-	const BoundingSphere s(vertices_subset);
+	hull.setPointsInPlace(vertices_subset, hullSeed(b, n));
+}
 
-	hull.x() = s.x();
-	hull.r() = s.r();
+void
+TriangleMeshBSH::mergeHulls(int, int, BoundingSphere const& hull0, BoundingSphere const& hull1,
+	BoundingSphere& hull) const
+{
+	hull = BoundingSphere(hull0, hull1);
 }
 
 TriangleMeshBBH::TriangleMeshBBH(
@@ -55,12 +77,13 @@ TriangleMeshBBH::TriangleMeshBBH(
 	: super(faces.size()), m_faces(faces), m_vertices(vertices), 
 		m_tri_centers(faces.size())
 {
-	std::transform(m_faces.begin(), m_faces.end(), m_tri_centers.begin(),
-		[&](Vector3i const& f)
-		{
-			return 1.0 / 3.0 * (m_vertices[f[0]] + m_vertices[f[1]] +
-				m_vertices[f[2]]);
-		});
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < static_cast<int>(m_faces.size()); ++i)
+	{
+		auto const& f = m_faces[i];
+		m_tri_centers[i] = 1.0 / 3.0 * (m_vertices[f[0]] + m_vertices[f[1]] +
+			m_vertices[f[2]]);
+	}
 }
 
 Vector3r const&
@@ -72,6 +95,7 @@ TriangleMeshBBH::entityPosition(int i) const
 void
 TriangleMeshBBH::computeHull(int b, int n, AlignedBox3r& hull) const
 {
+	hull.setEmpty();
 	for (auto i = 0u; i < n; ++i)
 	{
 		auto const& f = m_faces[m_lst[b + i]];
@@ -81,6 +105,12 @@ TriangleMeshBBH::computeHull(int b, int n, AlignedBox3r& hull) const
 	}
 }
 
+void
+TriangleMeshBBH::mergeHulls(int, int, AlignedBox3r const& hull0, AlignedBox3r const& hull1,
+	AlignedBox3r& hull) const
+{
+	hull = hull0.merged(hull1);
+}
 
 PointCloudBSH::PointCloudBSH()
 	: super(0)
@@ -102,14 +132,19 @@ PointCloudBSH::entityPosition(int i) const
 void
 PointCloudBSH::computeHull(int b, int n, BoundingSphere& hull) const
 {
-	auto vertices_subset = std::vector<Vector3r>(n);
+	auto& vertices_subset = hull_points;
+	vertices_subset.resize(n);
 	for (int i = b; i < n + b; ++i)
 		vertices_subset[i - b] = m_vertices[m_lst[i]];
 
-	const BoundingSphere s(vertices_subset);
+	hull.setPointsInPlace(vertices_subset, hullSeed(b, n));
+}
 
-	hull.x() = s.x();
-	hull.r() = s.r();
+void
+PointCloudBSH::mergeHulls(int, int, BoundingSphere const& hull0, BoundingSphere const& hull1,
+	BoundingSphere& hull) const
+{
+	hull = BoundingSphere(hull0, hull1);
 }
 
 
@@ -0,0 +1,132 @@
+#include <acceleration/min_max_pyramid.hpp>
+
+#include <algorithm>
+#include <limits>
+
+using namespace Eigen;
+
+namespace Discregrid
+{
+
+namespace
+{
+
+std::array<real, 2> const empty_range = {{std::numeric_limits<real>::max(), std::numeric_limits<real>::lowest()}};
+
+bool
+isEmpty(std::array<real, 2> const& range)
+{
+	return range[0] > range[1];
+}
+
+}
+
+MinMaxPyramid::MinMaxPyramid(Vector3i const& resolution, CellRange const& cell_range)
+	: m_cell_resolution(resolution)
+{
+	auto const& n = resolution;
+	auto bs = blockSize();
+
+	auto level = Level{};
+	level.resolution = ((n + Vector3i::Constant(bs - 1)).array() / bs).matrix();
+	level.ranges.resize(level.resolution.prod());
+#pragma omp parallel for schedule(dynamic, 16)
+	for (int b = 0; b < static_cast<int>(level.ranges.size()); ++b)
+	{
+		auto range = empty_range;
+		for (auto l : blockCells(b))
+		{
+			real min, max;
+			if (cell_range(l, min, max))
+			{
+				range[0] = std::min(range[0], min);
+				range[1] = std::max(range[1], max);
+			}
+		}
+		level.ranges[b] = range;
+	}
+	m_levels.push_back(std::move(level));
+
+	while (m_levels.back().resolution != Vector3i::Ones())
+	{
+		auto const& fine = m_levels.back();
+		auto coarse = Level{};
+		coarse.resolution = ((fine.resolution + Vector3i::Ones()).array() / 2).matrix();
+		coarse.ranges.assign(coarse.resolution.prod(), empty_range);
+		for (auto k = 0; k < fine.resolution[2]; ++k)
+		{
+			for (auto j = 0; j < fine.resolution[1]; ++j)
+			{
+				for (auto i = 0; i < fine.resolution[0]; ++i)
+				{
+					auto const& range = fine.ranges[i + fine.resolution[0] * (j + fine.resolution[1] * k)];
+					auto& coarse_range = coarse.ranges[i / 2 + coarse.resolution[0] * (j / 2 + coarse.resolution[1] * (k / 2))];
+					coarse_range[0] = std::min(coarse_range[0], range[0]);
+					coarse_range[1] = std::max(coarse_range[1], range[1]);
+				}
+			}
+		}
+		m_levels.push_back(std::move(coarse));
+	}
+}
+
+std::vector<int>
+MinMaxPyramid::findBlocks(RangePredicate const& pred) const
+{
+	if (m_levels.empty())
+		return {};
+
+	// The blocks are refined level by level, where the children of a block are
+	// the blocks of the finer level covered by it.
+	auto blocks = std::vector<int>{0};
+	for (auto level = nLevels() - 1; level >= 0; --level)
+	{
+		auto const& r = m_levels[level];
+		auto selected = std::vector<int>{};
+		for (auto b : blocks)
+		{
+			if (!isEmpty(r.ranges[b]) && pred(r.ranges[b][0], r.ranges[b][1]))
+				selected.push_back(b);
+		}
+		if (level == 0)
+		{
+			std::sort(selected.begin(), selected.end());
+			return selected;
+		}
+
+		auto const& f = m_levels[level - 1];
+		blocks.clear();
+		for (auto b : selected)
+		{
+			auto i = b % r.resolution[0];
+			auto j = b / r.resolution[0] % r.resolution[1];
+			auto k = b / (r.resolution[0] * r.resolution[1]);
+			for (auto fk = 2 * k; fk < std::min(2 * k + 2, f.resolution[2]); ++fk)
+				for (auto fj = 2 * j; fj < std::min(2 * j + 2, f.resolution[1]); ++fj)
+					for (auto fi = 2 * i; fi < std::min(2 * i + 2, f.resolution[0]); ++fi)
+						blocks.push_back(fi + f.resolution[0] * (fj + f.resolution[1] * fk));
+		}
+	}
+	return {};
+}
+
+std::vector<int>
+MinMaxPyramid::blockCells(int b) const
+{
+	// The lowest level may not have been built yet.
+	auto const& n = m_cell_resolution;
+	auto bs = blockSize();
+	auto r = ((n + Vector3i::Constant(bs - 1)).array() / bs).matrix().eval();
+	auto i = b % r[0];
+	auto j = b / r[0] % r[1];
+	auto k = b / (r[0] * r[1]);
+
+	auto cells = std::vector<int>{};
+	for (auto ck = k * bs; ck < std::min((k + 1) * bs, n[2]); ++ck)
+		for (auto cj = j * bs; cj < std::min((j + 1) * bs, n[1]); ++cj)
+			for (auto ci = i * bs; ci < std::min((i + 1) * bs, n[0]); ++ci)
+				cells.push_back(ci + n[0] * (cj + n[1] * ck));
+	return cells;
+}
+
+}
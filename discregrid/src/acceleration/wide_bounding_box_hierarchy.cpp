@@ -0,0 +1,193 @@
+#include <acceleration/wide_bounding_box_hierarchy.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+using namespace Eigen;
+
+namespace Discregrid
+{
+
+namespace
+{
+
+// Number of bins of the triangle centers along the split axis.
+int const n_bins = 16;
+
+real
+halfArea(AlignedBox3r const& box)
+{
+	if (box.isEmpty())
+		return real(0);
+	auto d = box.diagonal();
+	return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+}
+
+}
+
+TriangleMeshWideBBH::TriangleMeshWideBBH(
+	std::span<const Vector3r> vertices,
+	std::span<const Vector3i> faces)
+	: m_vertices(vertices), m_faces(faces)
+{
+}
+
+void
+TriangleMeshWideBBH::construct()
+{
+	m_nodes.clear();
+	m_lst.resize(m_faces.size());
+	if (m_lst.empty())
+		return;
+	std::iota(m_lst.begin(), m_lst.end(), 0);
+
+	m_tri_centers.resize(m_faces.size());
+	m_tri_boxes.resize(m_faces.size());
+#pragma omp parallel for schedule(static)
+	for (int f = 0; f < static_cast<int>(m_faces.size()); ++f)
+	{
+		auto const& face = m_faces[f];
+		m_tri_boxes[f] = AlignedBox3r(m_vertices[face[0]]);
+		m_tri_boxes[f].extend(m_vertices[face[1]]);
+		m_tri_boxes[f].extend(m_vertices[face[2]]);
+		m_tri_centers[f] = 1.0 / 3.0 * (m_vertices[face[0]] + m_vertices[face[1]] + m_vertices[face[2]]);
+	}
+
+	auto root = Range{0, static_cast<int>(m_lst.size()), AlignedBox3r{}, AlignedBox3r{}};
+	for (auto f = 0u; f < m_lst.size(); ++f)
+	{
+		root.box.extend(m_tri_boxes[f]);
+		root.centers.extend(m_tri_centers[f]);
+	}
+	addNode(root, 0);
+
+	m_tri_centers = {};
+	m_tri_boxes = {};
+}
+
+int
+TriangleMeshWideBBH::addNode(Range const& range, int depth)
+{
+	// The child with the largest surface area is split until there are four
+	// children or all of them are small enough to become leaves.
+	std::array<Range, 4> children;
+	children[0] = range;
+	auto n_children = 1;
+	while (n_children < width())
+	{
+		auto largest = -1;
+		for (auto c = 0; c < n_children; ++c)
+		{
+			if (children[c].n > maxLeafSize() &&
+				(largest < 0 || halfArea(children[c].box) > halfArea(children[largest].box)))
+				largest = c;
+		}
+		if (largest < 0)
+			break;
+
+		auto parent = children[largest];
+		split(parent, children[largest], children[n_children++]);
+	}
+
+	auto index = static_cast<int>(m_nodes.size());
+	m_nodes.emplace_back();
+	for (auto c = 0; c < width(); ++c)
+	{
+		auto is_used = c < n_children;
+		auto child = -1;
+		auto count = 0;
+		if (is_used && (children[c].n <= maxLeafSize() || depth + 1 >= maxDepth()))
+		{
+			child = children[c].begin;
+			count = children[c].n;
+		}
+		else if (is_used)
+		{
+			child = addNode(children[c], depth + 1);
+		}
+
+		auto& node = m_nodes[index];
+		node.children[c] = child;
+		node.counts[c] = count;
+		for (auto a = 0; a < 3; ++a)
+		{
+			node.min[a][c] = is_used ? children[c].box.min()[a] : std::numeric_limits<real>::max();
+			node.max[a][c] = is_used ? children[c].box.max()[a] : std::numeric_limits<real>::lowest();
+		}
+	}
+	return index;
+}
+
+void
+TriangleMeshWideBBH::split(Range const& range, Range& left, Range& right)
+{
+	auto begin = m_lst.begin() + range.begin;
+	auto end = begin + range.n;
+
+	auto extent = range.centers.diagonal().eval();
+	auto axis = 0;
+	extent.maxCoeff(&axis);
+
+	// If all centers coincide, the triangles are split in halves.
+	auto split_index = range.n / 2;
+	if (extent[axis] > real(0))
+	{
+		auto bin = [&](int f)
+		{
+			auto b = static_cast<int>(n_bins * (m_tri_centers[f][axis] - range.centers.min()[axis]) / extent[axis]);
+			return std::min(b, n_bins - 1);
+		};
+
+		std::array<int, n_bins> counts;
+		std::array<AlignedBox3r, n_bins> boxes;
+		counts.fill(0);
+		for (auto it = begin; it != end; ++it)
+		{
+			auto b = bin(*it);
+			++counts[b];
+			boxes[b].extend(m_tri_boxes[*it]);
+		}
+
+		// Cost of splitting after bin b according to the surface area heuristic.
+		std::array<real, n_bins> right_costs;
+		auto box = AlignedBox3r{};
+		auto count = 0;
+		for (auto b = n_bins - 1; b > 0; --b)
+		{
+			box.extend(boxes[b]);
+			count += counts[b];
+			right_costs[b - 1] = halfArea(box) * count;
+		}
+		auto best = -1;
+		auto best_cost = std::numeric_limits<real>::max();
+		box.setEmpty();
+		count = 0;
+		for (auto b = 0; b < n_bins - 1; ++b)
+		{
+			box.extend(boxes[b]);
+			count += counts[b];
+			auto cost = halfArea(box) * count + right_costs[b];
+			if (count > 0 && count < range.n && cost < best_cost)
+			{
+				best = b;
+				best_cost = cost;
+			}
+		}
+
+		auto middle = std::partition(begin, end, [&](int f) { return bin(f) <= best; });
+		split_index = static_cast<int>(middle - begin);
+	}
+
+	left = Range{range.begin, split_index, AlignedBox3r{}, AlignedBox3r{}};
+	right = Range{range.begin + split_index, range.n - split_index, AlignedBox3r{}, AlignedBox3r{}};
+	for (auto r : {&left, &right})
+	{
+		for (auto i = r->begin; i < r->begin + r->n; ++i)
+		{
+			r->box.extend(m_tri_boxes[m_lst[i]]);
+			r->centers.extend(m_tri_centers[m_lst[i]]);
+		}
+	}
+}
+
+}
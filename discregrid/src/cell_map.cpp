@@ -0,0 +1,162 @@
+#include <cell_map.hpp>
+#include <utility/serialize.hpp>
+
+#include <numeric>
+#include <algorithm>
+
+namespace Discregrid
+{
+
+CellMap::CellMap(Eigen::Vector3i const& resolution)
+	: m_identity(true), m_resolution(resolution)
+{
+}
+
+template <typename Predicate>
+void
+CellMap::buildBlocks(Predicate const& is_kept)
+{
+	auto& r = m_resolution;
+	m_n_blocks = (r.array() + 3) / 4;
+	auto n_blocks = m_n_blocks.prod();
+
+	m_masks.assign(n_blocks, 0u);
+#pragma omp parallel for schedule(static)
+	for (int b = 0; b < n_blocks; ++b)
+	{
+		auto bi = b % m_n_blocks[0];
+		auto bj = (b / m_n_blocks[0]) % m_n_blocks[1];
+		auto bk = b / (m_n_blocks[0] * m_n_blocks[1]);
+		for (auto bit = 0; bit < 64; ++bit)
+		{
+			auto i = 4 * bi + (bit & 3);
+			auto j = 4 * bj + ((bit >> 2) & 3);
+			auto k = 4 * bk + (bit >> 4);
+			if (i < r[0] && j < r[1] && k < r[2] && is_kept((r[1] * k + j) * r[0] + i))
+				m_masks[b] |= uint64_t{1} << bit;
+		}
+	}
+
+	m_offsets.resize(n_blocks + 1);
+	m_offsets[0] = 0;
+	for (auto b = 0; b < n_blocks; ++b)
+		m_offsets[b + 1] = m_offsets[b] + CellMapView::popcount(m_masks[b]);
+	m_cells.resize(m_offsets.back());
+}
+
+CellMap::CellMap(Eigen::Vector3i const& resolution, std::vector<int> const& cell_map)
+	: m_identity(false), m_resolution(resolution)
+{
+	auto is_identity = true;
+	for (auto l = 0u; l < cell_map.size() && is_identity; ++l)
+		is_identity = cell_map[l] == static_cast<int>(l);
+	if (is_identity)
+	{
+		m_identity = true;
+		return;
+	}
+
+	buildBlocks([&](int l) { return cell_map[l] != std::numeric_limits<int>::max(); });
+
+	auto& r = m_resolution;
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(cell_map.size()); ++l)
+	{
+		if (cell_map[l] == std::numeric_limits<int>::max())
+			continue;
+
+		auto i = l % r[0];
+		auto j = (l / r[0]) % r[1];
+		auto k = l / (r[0] * r[1]);
+		auto b = (m_n_blocks[1] * (k >> 2) + (j >> 2)) * m_n_blocks[0] + (i >> 2);
+		auto bit = ((k & 3) << 4) | ((j & 3) << 2) | (i & 3);
+		m_cells[m_offsets[b] + CellMapView::popcount(m_masks[b] & ((uint64_t{1} << bit) - 1u))] = cell_map[l];
+	}
+}
+
+CellMap::CellMap(Eigen::Vector3i const& resolution, std::vector<char> const& keep_cell)
+	: m_identity(false), m_resolution(resolution)
+{
+	if (std::all_of(keep_cell.begin(), keep_cell.end(), [](char keep) { return keep != 0; }))
+	{
+		m_identity = true;
+		return;
+	}
+
+	buildBlocks([&](int l) { return keep_cell[l] != 0; });
+
+	// Number the remaining cells row by row.
+	auto& r = m_resolution;
+	auto n_rows = r[1] * r[2];
+	auto row_offsets = std::vector<int>(n_rows + 1, 0);
+#pragma omp parallel for schedule(static)
+	for (int row = 0; row < n_rows; ++row)
+		row_offsets[row + 1] = static_cast<int>(std::count_if(keep_cell.begin() + row * r[0],
+			keep_cell.begin() + (row + 1) * r[0], [](char keep) { return keep != 0; }));
+	std::partial_sum(row_offsets.begin(), row_offsets.end(), row_offsets.begin());
+
+#pragma omp parallel for schedule(static)
+	for (int row = 0; row < n_rows; ++row)
+	{
+		auto j = row % r[1];
+		auto k = row / r[1];
+		auto index = row_offsets[row];
+		for (auto i = 0; i < r[0]; ++i)
+		{
+			if (!keep_cell[row * r[0] + i])
+				continue;
+
+			auto b = (m_n_blocks[1] * (k >> 2) + (j >> 2)) * m_n_blocks[0] + (i >> 2);
+			auto bit = ((k & 3) << 4) | ((j & 3) << 2) | (i & 3);
+			m_cells[m_offsets[b] + CellMapView::popcount(m_masks[b] & ((uint64_t{1} << bit) - 1u))] = index++;
+		}
+	}
+}
+
+CellMap::CellMap(CellMapView const& view)
+	: m_identity(view.isIdentity()), m_resolution(view.resolution())
+{
+	if (m_identity)
+		return;
+
+	auto n_blocks = view.nBlocks();
+	m_n_blocks = (m_resolution.array() + 3) / 4;
+	m_masks.assign(view.masks(), view.masks() + n_blocks);
+	m_offsets.assign(view.offsets(), view.offsets() + n_blocks + 1);
+	m_cells.assign(view.cells(), view.cells() + m_offsets.back());
+}
+
+std::vector<int>
+CellMap::toDense() const
+{
+	auto cell_map = std::vector<int>(size());
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(cell_map.size()); ++l)
+		cell_map[l] = (*this)[l];
+	return cell_map;
+}
+
+bool
+CellMap::write(std::streambuf& buf) const
+{
+	return serialize::write(buf, static_cast<char>(m_identity)) &&
+		serialize::write(buf, m_resolution) &&
+		serialize::write(buf, m_masks) &&
+		serialize::write(buf, m_offsets) &&
+		serialize::write(buf, m_cells);
+}
+
+bool
+CellMap::read(std::streambuf& buf)
+{
+	auto identity = char{};
+	if (!serialize::read(buf, identity) || !serialize::read(buf, m_resolution))
+		return false;
+	m_identity = identity != 0;
+	m_n_blocks = (m_resolution.array() + 3) / 4;
+	return serialize::read(buf, m_masks) &&
+		serialize::read(buf, m_offsets) &&
+		serialize::read(buf, m_cells);
+}
+
+}
@@ -1,6 +1,13 @@
 #include "data/z_sort_table.hpp"
 #include "cubic_lagrange_discrete_grid.hpp"
+#include "cubic_lagrange_interpolation.hpp"
+#include "grid_file_format.hpp"
+#include "iso_surface.hpp"
+#include "mesh/mesh_writer.hpp"
+#include "utility/compression.hpp"
+#include <geometry/mesh_distance.hpp>
 #include <utility/serialize.hpp>
+#include "geometry/point_triangle_distance.hpp"
 #include "utility/spinlock.hpp"
 #include "utility/timing.hpp"
 
@@ -8,9 +15,13 @@
 #include <iomanip>
 #include <atomic>
 #include <numeric>
-#include <set>
+#include <algorithm>
 #include <chrono>
 #include <future>
+#include <deque>
+#include <cstring>
+#include <cstdio>
+#include <omp.h>
 
 using namespace Eigen;
 
@@ -579,352 +590,477 @@ shape_function_(Vector3r const &xi, Matrix<real, 32, 3> *gradient = nullptr)
 	return res;
 }
 
-// Determines Morten value according to z-curve.
-inline uint64_t
-zValue(Vector3r const &x, real invCellSize)
+// Offset of node j of a cell on the node lattice in direction d, which has a
+// third of the cell size as spacing.
+inline int
+lattice_offset(int j, int d)
 {
-	std::array<int, 3> key;
-	for (int i(0); i < 3; ++i)
+	return static_cast<int>(std::round(1.5 * (abscissae_[j][d] + 1.0)));
+}
+
+// Computes the exclusive prefix sum of flags in parallel and returns the number
+// of set flags.
+int
+parallel_exclusive_scan(std::vector<char> const& flags, std::vector<int>& offsets)
+{
+	auto n = static_cast<int>(flags.size());
+	auto n_chunks = std::max(1, std::min(omp_get_max_threads(), n));
+	auto chunk_sum = std::vector<int>(n_chunks + 1, 0);
+	offsets.resize(flags.size());
+
+#pragma omp parallel for schedule(static, 1)
+	for (int c = 0; c < n_chunks; ++c)
 	{
-		if (x[i] >= 0.0)
-			key[i] = static_cast<int>(invCellSize * x[i]);
-		else
-			key[i] = static_cast<int>(invCellSize * x[i]) - 1;
+		auto begin = static_cast<int>(static_cast<int64_t>(n) * c / n_chunks);
+		auto end = static_cast<int>(static_cast<int64_t>(n) * (c + 1) / n_chunks);
+		chunk_sum[c + 1] = static_cast<int>(std::count_if(flags.begin() + begin, flags.begin() + end,
+			[](char f) { return f != 0; }));
 	}
+	std::partial_sum(chunk_sum.begin(), chunk_sum.end(), chunk_sum.begin());
 
-	std::array<unsigned int, 3> p = {
-		static_cast<unsigned int>(static_cast<int64_t>(key[0]) - (std::numeric_limits<int>::lowest() + 1)),
-		static_cast<unsigned int>(static_cast<int64_t>(key[1]) - (std::numeric_limits<int>::lowest() + 1)),
-		static_cast<unsigned int>(static_cast<int64_t>(key[2]) - (std::numeric_limits<int>::lowest() + 1))};
+#pragma omp parallel for schedule(static, 1)
+	for (int c = 0; c < n_chunks; ++c)
+	{
+		auto begin = static_cast<int>(static_cast<int64_t>(n) * c / n_chunks);
+		auto end = static_cast<int>(static_cast<int64_t>(n) * (c + 1) / n_chunks);
+		auto sum = chunk_sum[c];
+		for (auto l = begin; l < end; ++l)
+		{
+			offsets[l] = sum;
+			sum += flags[l] != 0;
+		}
+	}
 
-	return morton_lut(p);
+	return chunk_sum.back();
 }
-} // namespace
 
-Vector3r
-CubicLagrangeDiscreteGrid::indexToNodePosition(int l) const
+// Sorts values in parallel by sorting chunks concurrently and merging them pairwise.
+template <typename T>
+void
+parallel_sort(std::vector<T>& values)
 {
-	auto x = Vector3r{};
-
-	auto& n = m_resolution;
-
-	auto nv = (n[0] + 1) * (n[1] + 1) * (n[2] + 1);
-	auto ne_x = (n[0] + 0) * (n[1] + 1) * (n[2] + 1);
-	auto ne_y = (n[0] + 1) * (n[1] + 0) * (n[2] + 1);
-	auto ne_z = (n[0] + 1) * (n[1] + 1) * (n[2] + 0);
-	auto ne = ne_x + ne_y + ne_z;
-
-	auto ijk = Matrix<int, 3, 1>{};
-	if (l < nv)
+	auto n_chunks = omp_get_max_threads();
+	if (n_chunks < 2 || values.size() < 1u << 16)
 	{
-		ijk(2) = l / ((n[1] + 1) * (n[0] + 1));
-		auto temp = l % ((n[1] + 1) * (n[0] + 1));
-		ijk(1) = temp / (n[0] + 1);
-		ijk(0) = temp % (n[0] + 1);
-
-		x = m_domain.min() + m_cell_size.cwiseProduct(ijk.cast<real>());
+		std::sort(values.begin(), values.end());
+		return;
 	}
-	else if (l < nv + 2 * ne_x)
-	{
-		l -= nv;
-		auto e_ind = l / 2;
-		ijk(2) = e_ind / ((n[1] + 1) * n[0]);
-		auto temp = e_ind % ((n[1] + 1) * n[0]);
-		ijk(1) = temp / n[0];
-		ijk(0) = temp % n[0];
 
-		x = m_domain.min() + m_cell_size.cwiseProduct(ijk.cast<real>());
-		x(0) += (1.0 + static_cast<real>(l % 2)) / 3.0 * m_cell_size[0];
-	}
-	else if (l < nv + 2 * (ne_x + ne_y))
-	{
-		l -= (nv + 2 * ne_x);
-		auto e_ind = l / 2;
-		ijk(0) = e_ind / ((n[2] + 1) * n[1]);
-		auto temp = e_ind % ((n[2] + 1) * n[1]);
-		ijk(2) = temp / n[1];
-		ijk(1) = temp % n[1];
+	auto bounds = std::vector<std::size_t>(n_chunks + 1);
+	for (auto c = 0; c <= n_chunks; ++c)
+		bounds[c] = values.size() * c / n_chunks;
 
-		x = m_domain.min() + m_cell_size.cwiseProduct(ijk.cast<real>());
-		x(1) += (1.0 + static_cast<real>(l % 2)) / 3.0 * m_cell_size[1];
-	}
-	else
-	{
-		l -= (nv + 2 * (ne_x + ne_y));
-		auto e_ind = l / 2;
-		ijk(1) = e_ind / ((n[0] + 1) * n[2]);
-		auto temp = e_ind % ((n[0] + 1) * n[2]);
-		ijk(0) = temp / n[2];
-		ijk(2) = temp % n[2];
+#pragma omp parallel for schedule(static, 1)
+	for (int c = 0; c < n_chunks; ++c)
+		std::sort(values.begin() + bounds[c], values.begin() + bounds[c + 1]);
 
-		x = m_domain.min() + m_cell_size.cwiseProduct(ijk.cast<real>());
-		x(2) += (1.0 + static_cast<real>(l % 2)) / 3.0 * m_cell_size[2];
+	auto buffer = std::vector<T>(values.size());
+	for (auto width = 1; width < n_chunks; width *= 2)
+	{
+#pragma omp parallel for schedule(static, 1)
+		for (int c = 0; c < n_chunks; c += 2 * width)
+		{
+			auto begin = bounds[c];
+			auto mid = bounds[std::min(c + width, n_chunks)];
+			auto end = bounds[std::min(c + 2 * width, n_chunks)];
+			std::merge(values.begin() + begin, values.begin() + mid, values.begin() + mid,
+				values.begin() + end, buffer.begin() + begin);
+		}
+		values.swap(buffer);
 	}
-
-	return x;
 }
 
-CubicLagrangeDiscreteGrid::CubicLagrangeDiscreteGrid(std::string const &filename)
+// Reads the geometry from the header of a grid file in the sectioned format.
+void
+read_geometry(grid_file::Header const& header, AlignedBox3r& domain, Eigen::Vector3i& resolution,
+	Vector3r& cell_size, Vector3r& inv_cell_size)
 {
-	load(filename);
+	resolution = Eigen::Vector3i(header.resolution[0], header.resolution[1], header.resolution[2]);
+	domain = AlignedBox3r(
+		Eigen::Vector3d(header.domain_min[0], header.domain_min[1], header.domain_min[2]).cast<real>(),
+		Eigen::Vector3d(header.domain_max[0], header.domain_max[1], header.domain_max[2]).cast<real>());
+	cell_size = Eigen::Vector3d(header.cell_size[0], header.cell_size[1], header.cell_size[2]).cast<real>();
+	inv_cell_size = Eigen::Vector3d(header.inv_cell_size[0], header.inv_cell_size[1],
+		header.inv_cell_size[2]).cast<real>();
 }
 
-CubicLagrangeDiscreteGrid::CubicLagrangeDiscreteGrid(AlignedBox3r const &domain,
-													 Eigen::Vector3i const &resolution)
-	: DiscreteGrid(domain, resolution)
+// Reads the geometry and the number of fields from the header of a grid file.
+bool
+read_grid_header(std::string const& filename, AlignedBox3r& domain, Eigen::Vector3i& resolution,
+	Vector3r& cell_size, std::size_t& n_fields)
 {
+	auto in = std::ifstream(filename, std::ios::binary);
+	if (!in.good())
+		return false;
+
+	auto inv_cell_size = Vector3r{};
+	auto magic = std::array<char, 8>{};
+	if (serialize::read(*in.rdbuf(), magic) &&
+		std::equal(magic.begin(), magic.end(), grid_file::magic))
+	{
+		in.close();
+		auto size = std::size_t{};
+		auto data = grid_file::mapFile(filename, size);
+		if (!data)
+			return false;
+
+		auto header = grid_file::Header{};
+		auto entries = std::vector<grid_file::FieldEntry>{};
+		auto valid = grid_file::readDirectory(data, size, header, entries);
+		grid_file::unmapFile(data, size);
+		if (valid)
+		{
+			read_geometry(header, domain, resolution, cell_size, inv_cell_size);
+			n_fields = static_cast<std::size_t>(header.n_fields);
+		}
+		return valid;
+	}
+	in.seekg(0);
+
+	auto n_cells = std::size_t{};
+	serialize::read(*in.rdbuf(), domain);
+	serialize::read(*in.rdbuf(), resolution);
+	serialize::read(*in.rdbuf(), cell_size);
+	serialize::read(*in.rdbuf(), inv_cell_size);
+	serialize::read(*in.rdbuf(), n_cells);
+	serialize::read(*in.rdbuf(), n_fields);
+
+	return in.good();
 }
 
-CubicLagrangeDiscreteGrid::CubicLagrangeDiscreteGrid(const AlignedBox3r& minimum_domain,
-                                                     const Vector3r& cell_size)
-    : DiscreteGrid(minimum_domain, cell_size)
+// Checks whether n_arrays arrays, each preceded by its size, can fit into the
+// remaining bytes of buf. Buffers that are not seekable are not checked.
+bool
+arrays_fit(std::streambuf& buf, std::size_t n_arrays)
 {
+	auto position = buf.pubseekoff(0, std::ios::cur, std::ios::in);
+	auto end = position < 0 ? position : buf.pubseekoff(0, std::ios::end, std::ios::in);
+	if (end < 0)
+		return true;
+	return static_cast<uint64_t>(end - position) / sizeof(std::size_t) >= n_arrays &&
+		buf.pubseekpos(position, std::ios::in) == position;
 }
 
-void CubicLagrangeDiscreteGrid::save(std::string const &filename) const
+// Reads an array of a legacy grid file if requested and skips it otherwise. If the
+// buffer is seekable, sizes exceeding the remaining bytes are rejected up front.
+template <typename T>
+bool
+read_or_skip(std::streambuf& buf, bool read, std::vector<T>& values)
 {
-	auto out = std::ofstream(filename, std::ios::binary);
-	serialize::write(*out.rdbuf(), m_domain);
-	serialize::write(*out.rdbuf(), m_resolution);
-	serialize::write(*out.rdbuf(), m_cell_size);
-	serialize::write(*out.rdbuf(), m_inv_cell_size);
-	serialize::write(*out.rdbuf(), m_n_cells);
-	serialize::write(*out.rdbuf(), m_n_fields);
+	auto start = buf.pubseekoff(0, std::ios::cur, std::ios::in);
+	auto size = std::size_t{};
+	if (!serialize::read(buf, size))
+		return false;
 
-	serialize::write(*out.rdbuf(), m_nodes.size());
-	for (auto const &nodes : m_nodes)
+	auto position = buf.pubseekoff(0, std::ios::cur, std::ios::in);
+	auto end = position < 0 ? position : buf.pubseekoff(0, std::ios::end, std::ios::in);
+	if (end < 0)
 	{
-		serialize::write(*out.rdbuf(), nodes.size());
-		for (auto const &node : nodes)
-		{
-			serialize::write(*out.rdbuf(), node);
-		}
+		// Buffers that are not seekable can only be read.
+		if (!read)
+			return false;
+		values.resize(size);
+		auto n_bytes = static_cast<std::streamsize>(size * sizeof(T));
+		return buf.sgetn(reinterpret_cast<char*>(values.data()), n_bytes) == n_bytes;
 	}
+	if (static_cast<uint64_t>(end - position) / sizeof(T) < size)
+		return false;
 
-	serialize::write(*out.rdbuf(), m_cells.size());
-	for (auto const &cells : m_cells)
-	{
-		serialize::write(*out.rdbuf(), cells.size());
-		for (auto const &cell : cells)
-		{
-			serialize::write(*out.rdbuf(), cell);
-		}
-	}
+	if (read)
+		return buf.pubseekpos(start, std::ios::in) == start && serialize::read(buf, values);
+	return buf.pubseekoff(position + static_cast<std::streamoff>(size * sizeof(T)), std::ios::beg, std::ios::in) >= 0;
+}
 
-	serialize::write(*out.rdbuf(), m_cell_map.size());
-	for (auto const &maps : m_cell_map)
+// Determines Morten value according to z-curve.
+inline uint64_t
+zValue(Vector3r const &x, real invCellSize)
+{
+	std::array<int, 3> key;
+	for (int i(0); i < 3; ++i)
 	{
-		serialize::write(*out.rdbuf(), maps.size());
-		for (auto const &map : maps)
-		{
-			serialize::write(*out.rdbuf(), map);
-		}
+		if (x[i] >= 0.0)
+			key[i] = static_cast<int>(invCellSize * x[i]);
+		else
+			key[i] = static_cast<int>(invCellSize * x[i]) - 1;
 	}
 
-	out.close();
+	std::array<unsigned int, 3> p = {
+		static_cast<unsigned int>(static_cast<int64_t>(key[0]) - (std::numeric_limits<int>::lowest() + 1)),
+		static_cast<unsigned int>(static_cast<int64_t>(key[1]) - (std::numeric_limits<int>::lowest() + 1)),
+		static_cast<unsigned int>(static_cast<int64_t>(key[2]) - (std::numeric_limits<int>::lowest() + 1))};
+
+	return morton_lut(p);
 }
 
-void CubicLagrangeDiscreteGrid::load(std::string const &filename)
+// Collects the arrays of a grid file in the order in which they are written and
+// assigns their sections, compressing them if requested.
+class SectionWriter
 {
-	auto in = std::ifstream(filename, std::ios::binary);
+public:
 
-	if (!in.good())
+	SectionWriter(std::size_t n_fields, bool compressed)
+		: m_end(grid_file::alignSection(sizeof(grid_file::Header) + n_fields * sizeof(grid_file::FieldEntry))),
+		m_compressed(compressed)
 	{
-		std::cerr << "ERROR: Discrete grid can not be loaded. Input file does not exist!" << std::endl;
-		return;
 	}
 
-	serialize::read(*in.rdbuf(), m_domain);
-	serialize::read(*in.rdbuf(), m_resolution);
-	serialize::read(*in.rdbuf(), m_cell_size);
-	serialize::read(*in.rdbuf(), m_inv_cell_size);
-	serialize::read(*in.rdbuf(), m_n_cells);
-	serialize::read(*in.rdbuf(), m_n_fields);
-
-	auto n_nodes = std::size_t{};
-	serialize::read(*in.rdbuf(), n_nodes);
-	m_nodes.resize(n_nodes);
-	for (auto &nodes : m_nodes)
+	template <typename T>
+	grid_file::Section add(T const* values, std::size_t n_rows, std::size_t n_columns = 1u)
 	{
-		serialize::read(*in.rdbuf(), n_nodes);
-		nodes.resize(n_nodes);
-		for (auto &node : nodes)
+		auto section = grid_file::Section{m_end, n_rows * n_columns * sizeof(T), 0u};
+		auto data = reinterpret_cast<char const*>(values);
+		if (m_compressed)
 		{
-			serialize::read(*in.rdbuf(), node);
+			m_buffers.push_back(compression::compress(values, n_rows, n_columns));
+			section.size = m_buffers.back().size();
+			data = m_buffers.back().data();
 		}
+		section.checksum = grid_file::checksum(data, static_cast<std::size_t>(section.size));
+		m_sections.push_back({section, data});
+		m_end = grid_file::alignSection(m_end + section.size);
+		return section;
 	}
 
-	auto n_cells = std::size_t{};
-	serialize::read(*in.rdbuf(), n_cells);
-	m_cells.resize(n_cells);
-	for (auto &cells : m_cells)
+	void write(std::streambuf& buf, grid_file::Header header,
+		std::vector<grid_file::FieldEntry> const& entries) const
 	{
-		serialize::read(*in.rdbuf(), n_cells);
-		cells.resize(n_cells);
-		for (auto &cell : cells)
+		header.directory_checksum = grid_file::directoryChecksum(header, entries);
+		serialize::write(buf, header);
+		for (auto const& entry : entries)
+			serialize::write(buf, entry);
+
+		auto position = sizeof(header) + entries.size() * sizeof(grid_file::FieldEntry);
+		auto const padding = std::array<char, grid_file::section_alignment>{};
+		for (auto const& section : m_sections)
 		{
-			serialize::read(*in.rdbuf(), cell);
+			buf.sputn(padding.data(), static_cast<std::streamsize>(section.first.offset - position));
+			buf.sputn(section.second, static_cast<std::streamsize>(section.first.size));
+			position = section.first.offset + section.first.size;
 		}
 	}
 
-	auto n_cell_maps = std::size_t{};
-	serialize::read(*in.rdbuf(), n_cell_maps);
-	m_cell_map.resize(n_cell_maps);
-	for (auto &cell_maps : m_cell_map)
+private:
+
+	uint64_t m_end;
+	bool m_compressed;
+	std::vector<std::pair<grid_file::Section, char const*>> m_sections;
+	std::deque<std::vector<char>> m_buffers;
+};
+
+// Reads the array of a section of a grid file, which is decompressed in parallel
+// if the file is compressed. Fails if the checksum of the section does not match.
+template <typename T>
+bool
+read_section(char const* data, grid_file::Section const& section, bool compressed,
+	std::vector<T>& values)
+{
+	if (!grid_file::hasValidChecksum(data, section))
+		return false;
+
+	auto begin = data + section.offset;
+	if (!compressed)
 	{
-		serialize::read(*in.rdbuf(), n_cell_maps);
-		cell_maps.resize(n_cell_maps);
-		for (auto &cell_map : cell_maps)
-		{
-			serialize::read(*in.rdbuf(), cell_map);
-		}
+		if (section.size % sizeof(T) != 0u)
+			return false;
+		values.resize(section.size / sizeof(T));
+		if (!values.empty())
+			std::memcpy(values.data(), begin, section.size);
+		return true;
 	}
 
-	in.close();
+	using Value = typename std::conditional<std::is_same<T, std::array<int, 32>>::value, int, T>::type;
+	auto n_values = std::size_t{};
+	if (!compression::decompressedSize<Value>(begin, section.size, n_values) ||
+		n_values % (sizeof(T) / sizeof(Value)) != 0u)
+		return false;
+	values.resize(n_values / (sizeof(T) / sizeof(Value)));
+	return compression::decompress(begin, section.size, reinterpret_cast<Value*>(values.data()), n_values);
 }
 
-int
-CubicLagrangeDiscreteGrid::addFunction(ContinuousFunction const &func, bool verbose,
-									   SamplePredicate const &pred)
+// Reads the field of the given directory entry of a grid file in the sectioned format.
+bool
+read_field(char const* data, grid_file::FieldEntry const& entry, bool compressed,
+	Eigen::Vector3i const& resolution, std::size_t n_cells, std::vector<real>& nodes,
+	std::vector<std::array<int, 32>>& cells, CellMap& cell_map)
 {
-	using namespace std::chrono;
-
-	auto t0_construction = high_resolution_clock::now();
+	if (!read_section(data, entry.nodes, compressed, nodes))
+		return false;
 
-	auto& n = m_resolution;
+	// The cells of fields that were not reduced are implied by the grid and not stored.
+	if (entry.identity && entry.cells.size == 0u)
+		cells.clear();
+	else if (!read_section(data, entry.cells, compressed, cells))
+		return false;
 
-	auto nv = (n[0] + 1) * (n[1] + 1) * (n[2] + 1);
-	auto ne_x = (n[0] + 0) * (n[1] + 1) * (n[2] + 1);
-	auto ne_y = (n[0] + 1) * (n[1] + 0) * (n[2] + 1);
-	auto ne_z = (n[0] + 1) * (n[1] + 1) * (n[2] + 0);
-	auto ne = ne_x + ne_y + ne_z;
+	if (entry.identity)
+	{
+		cell_map = CellMap(resolution);
+		return cells.empty() || cells.size() == n_cells;
+	}
 
-	auto n_nodes = nv + 2 * ne;
+	auto masks = std::vector<uint64_t>{};
+	auto offsets = std::vector<int>{};
+	auto cell_list = std::vector<int>{};
+	if (!read_section(data, entry.masks, compressed, masks) ||
+		!read_section(data, entry.block_offsets, compressed, offsets) ||
+		!read_section(data, entry.cell_list, compressed, cell_list) || offsets.empty() ||
+		!grid_file::isValidCellMap(resolution, masks.size(), offsets.data(), offsets.size(), cell_list.size()))
+		return false;
 
-	m_nodes.push_back({});
-	auto &coeffs = m_nodes.back();
-	coeffs.resize(n_nodes);
+	cell_map = CellMap(CellMapView(resolution, masks.data(), offsets.data(), cell_list.data()));
+	return true;
+}
 
-	std::atomic_int counter(0);
-	SpinLock mutex;
-	auto t0 = high_resolution_clock::now();
+// Data of a field held in memory, see cubic_lagrange::FieldView.
+cubic_lagrange::FieldView
+field_view(std::vector<real> const& nodes, std::vector<std::array<int, 32>> const& cells,
+	CellMap const& cell_map)
+{
+	return cubic_lagrange::FieldView{nodes.data(), cells.empty() ? nullptr : cells.data(), cell_map.view()};
+}
 
-#pragma omp parallel default(shared)
+// Read-only mapping of a grid file that is released on destruction.
+struct MappedFile
+{
+	explicit MappedFile(std::string const& filename)
+		: data(grid_file::mapFile(filename, size))
 	{
-#pragma omp for schedule(static) nowait
-		for (int l = 0; l < static_cast<int>(n_nodes); ++l)
-		{
-			auto x = indexToNodePosition(l);
-			auto &c = coeffs[l];
+	}
+	~MappedFile()
+	{
+		if (data)
+			grid_file::unmapFile(data, size);
+	}
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
 
-			if (!pred || pred(x))
-				c = func(x);
-			else
-				c = std::numeric_limits<real>::max();
+	std::size_t size = 0u;
+	char const* data;
+};
 
-			if (verbose && (++counter == n_nodes || duration_cast<milliseconds>(high_resolution_clock::now() - t0).count() > 1000))
-			{
-				std::async(std::launch::async, [&]() {
-					mutex.lock();
-					t0 = high_resolution_clock::now();
-					std::cout << "\r"
-							  << "Construction " << std::setw(20)
-							  << 100.0 * static_cast<real>(counter) / static_cast<real>(n_nodes) << "%";
-					mutex.unlock();
-				});
-			}
-		}
+// Read-only stream buffer on a block of memory, such that the stream format can
+// be parsed without copying the block first.
+class MemoryBuffer : public std::streambuf
+{
+public:
+
+	MemoryBuffer(char const* data, std::size_t size)
+	{
+		auto begin = const_cast<char*>(data);
+		setg(begin, begin, begin + size);
 	}
 
-	m_cells.push_back({});
-	auto &cells = m_cells.back();
-	cells.resize(m_n_cells);
-	for (auto l = 0; l < m_n_cells; ++l)
-	{
-		auto k = l / (n[1] * n[0]);
-		auto temp = l % (n[1] * n[0]);
-		auto j = temp / n[0];
-		auto i = temp % n[0];
-
-		auto nx = n[0];
-		auto ny = n[1];
-		auto nz = n[2];
-
-		auto &cell = cells[l];
-		cell[0] = (nx + 1) * (ny + 1) * k + (nx + 1) * j + i;
-		cell[1] = (nx + 1) * (ny + 1) * k + (nx + 1) * j + i + 1;
-		cell[2] = (nx + 1) * (ny + 1) * k + (nx + 1) * (j + 1) + i;
-		cell[3] = (nx + 1) * (ny + 1) * k + (nx + 1) * (j + 1) + i + 1;
-		cell[4] = (nx + 1) * (ny + 1) * (k + 1) + (nx + 1) * j + i;
-		cell[5] = (nx + 1) * (ny + 1) * (k + 1) + (nx + 1) * j + i + 1;
-		cell[6] = (nx + 1) * (ny + 1) * (k + 1) + (nx + 1) * (j + 1) + i;
-		cell[7] = (nx + 1) * (ny + 1) * (k + 1) + (nx + 1) * (j + 1) + i + 1;
-
-		auto offset = nv;
-		cell[8] = offset + 2 * (nx * (ny + 1) * k + nx * j + i);
-		cell[9] = cell[8] + 1;
-		cell[10] = offset + 2 * (nx * (ny + 1) * (k + 1) + nx * j + i);
-		cell[11] = cell[10] + 1;
-		cell[12] = offset + 2 * (nx * (ny + 1) * k + nx * (j + 1) + i);
-		cell[13] = cell[12] + 1;
-		cell[14] = offset + 2 * (nx * (ny + 1) * (k + 1) + nx * (j + 1) + i);
-		cell[15] = cell[14] + 1;
-
-		offset += 2 * ne_x;
-		cell[16] = offset + 2 * (ny * (nz + 1) * i + ny * k + j);
-		cell[17] = cell[16] + 1;
-		cell[18] = offset + 2 * (ny * (nz + 1) * (i + 1) + ny * k + j);
-		cell[19] = cell[18] + 1;
-		cell[20] = offset + 2 * (ny * (nz + 1) * i + ny * (k + 1) + j);
-		cell[21] = cell[20] + 1;
-		cell[22] = offset + 2 * (ny * (nz + 1) * (i + 1) + ny * (k + 1) + j);
-		cell[23] = cell[22] + 1;
-
-		offset += 2 * ne_y;
-		cell[24] = offset + 2 * (nz * (nx + 1) * j + nz * i + k);
-		cell[25] = cell[24] + 1;
-		cell[26] = offset + 2 * (nz * (nx + 1) * (j + 1) + nz * i + k);
-		cell[27] = cell[26] + 1;
-		cell[28] = offset + 2 * (nz * (nx + 1) * j + nz * (i + 1) + k);
-		cell[29] = cell[28] + 1;
-		cell[30] = offset + 2 * (nz * (nx + 1) * (j + 1) + nz * (i + 1) + k);
-		cell[31] = cell[30] + 1;
-	}
-
-	m_cell_map.push_back({});
-	auto &cell_map = m_cell_map.back();
-	cell_map.resize(m_n_cells);
-	std::iota(cell_map.begin(), cell_map.end(), 0);
+protected:
 
-	if (verbose)
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override
 	{
-		std::cout << "\rConstruction took " << std::setw(15) << static_cast<real>(duration_cast<milliseconds>(high_resolution_clock::now() - t0_construction).count()) / 1000.0 << "s" << std::endl;
+		auto base = dir == std::ios_base::beg ? off_type{0} :
+			dir == std::ios_base::end ? off_type(egptr() - eback()) : off_type(gptr() - eback());
+		if (off < -base || off > egptr() - eback() - base)
+			return pos_type(off_type(-1));
+		setg(eback(), eback() + base + off, egptr());
+		return pos_type(base + off);
 	}
 
-	return static_cast<int>(m_n_fields++);
+	pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+	{
+		return seekoff(off_type(pos), std::ios_base::beg, which);
+	}
+};
+} // namespace
+
+namespace cubic_lagrange
+{
+
+std::array<int, 32>
+denseCell(Eigen::Vector3i const& resolution, int l)
+{
+	auto& n = resolution;
+
+	auto nv = (n[0] + 1) * (n[1] + 1) * (n[2] + 1);
+	auto ne_x = (n[0] + 0) * (n[1] + 1) * (n[2] + 1);
+	auto ne_y = (n[0] + 1) * (n[1] + 0) * (n[2] + 1);
+
+	auto cell = std::array<int, 32>{};
+	auto k = l / (n[1] * n[0]);
+	auto temp = l % (n[1] * n[0]);
+	auto j = temp / n[0];
+	auto i = temp % n[0];
+
+	auto nx = n[0];
+	auto ny = n[1];
+	auto nz = n[2];
+
+	cell[0] = (nx + 1) * (ny + 1) * k + (nx + 1) * j + i;
+	cell[1] = (nx + 1) * (ny + 1) * k + (nx + 1) * j + i + 1;
+	cell[2] = (nx + 1) * (ny + 1) * k + (nx + 1) * (j + 1) + i;
+	cell[3] = (nx + 1) * (ny + 1) * k + (nx + 1) * (j + 1) + i + 1;
+	cell[4] = (nx + 1) * (ny + 1) * (k + 1) + (nx + 1) * j + i;
+	cell[5] = (nx + 1) * (ny + 1) * (k + 1) + (nx + 1) * j + i + 1;
+	cell[6] = (nx + 1) * (ny + 1) * (k + 1) + (nx + 1) * (j + 1) + i;
+	cell[7] = (nx + 1) * (ny + 1) * (k + 1) + (nx + 1) * (j + 1) + i + 1;
+
+	auto offset = nv;
+	cell[8] = offset + 2 * (nx * (ny + 1) * k + nx * j + i);
+	cell[9] = cell[8] + 1;
+	cell[10] = offset + 2 * (nx * (ny + 1) * (k + 1) + nx * j + i);
+	cell[11] = cell[10] + 1;
+	cell[12] = offset + 2 * (nx * (ny + 1) * k + nx * (j + 1) + i);
+	cell[13] = cell[12] + 1;
+	cell[14] = offset + 2 * (nx * (ny + 1) * (k + 1) + nx * (j + 1) + i);
+	cell[15] = cell[14] + 1;
+
+	offset += 2 * ne_x;
+	cell[16] = offset + 2 * (ny * (nz + 1) * i + ny * k + j);
+	cell[17] = cell[16] + 1;
+	cell[18] = offset + 2 * (ny * (nz + 1) * (i + 1) + ny * k + j);
+	cell[19] = cell[18] + 1;
+	cell[20] = offset + 2 * (ny * (nz + 1) * i + ny * (k + 1) + j);
+	cell[21] = cell[20] + 1;
+	cell[22] = offset + 2 * (ny * (nz + 1) * (i + 1) + ny * (k + 1) + j);
+	cell[23] = cell[22] + 1;
+
+	offset += 2 * ne_y;
+	cell[24] = offset + 2 * (nz * (nx + 1) * j + nz * i + k);
+	cell[25] = cell[24] + 1;
+	cell[26] = offset + 2 * (nz * (nx + 1) * (j + 1) + nz * i + k);
+	cell[27] = cell[26] + 1;
+	cell[28] = offset + 2 * (nz * (nx + 1) * j + nz * (i + 1) + k);
+	cell[29] = cell[28] + 1;
+	cell[30] = offset + 2 * (nz * (nx + 1) * (j + 1) + nz * (i + 1) + k);
+	cell[31] = cell[30] + 1;
+
+	return cell;
+}
+
+
+Eigen::Matrix<real, 32, 1>
+shapeFunctions(Vector3r const& xi, Eigen::Matrix<real, 32, 3>* dN)
+{
+	return shape_function_(xi, dN);
 }
 
 bool
-CubicLagrangeDiscreteGrid::determineShapeFunctions(int field_id, Vector3r const &x,
+determineShapeFunctions(DiscreteGrid const& grid, FieldView const& field, Vector3r const &x,
 	std::array<int, 32> &cell, Vector3r &c0, Eigen::Matrix<real, 32, 1> &N,
-	Eigen::Matrix<real, 32, 3> *dN) const
+	Eigen::Matrix<real, 32, 3> *dN)
 {
-	if (!m_domain.contains(x))
+	if (!grid.domain().contains(x))
 		return false;
 
-	auto mi = (x - m_domain.min()).cwiseProduct(m_inv_cell_size).cast<int>().eval();
-	if (mi[0] >= m_resolution[0])
-		mi[0] = m_resolution[0] - 1;
-	if (mi[1] >= m_resolution[1])
-		mi[1] = m_resolution[1] - 1;
-	if (mi[2] >= m_resolution[2])
-		mi[2] = m_resolution[2] - 1;
-	auto i = multiToSingleIndex({ mi(0), mi(1), mi(2) });
-	auto i_ = m_cell_map[field_id][i];
+	auto mi = (x - grid.domain().min()).cwiseProduct(grid.invCellSize()).cast<int>().eval();
+	if (mi[0] >= grid.resolution()[0])
+		mi[0] = grid.resolution()[0] - 1;
+	if (mi[1] >= grid.resolution()[1])
+		mi[1] = grid.resolution()[1] - 1;
+	if (mi[2] >= grid.resolution()[2])
+		mi[2] = grid.resolution()[2] - 1;
+	auto i = grid.multiToSingleIndex({ mi(0), mi(1), mi(2) });
+	auto i_ = field.cell_map[i];
 	if (i_ == std::numeric_limits<int>::max())
 		return false;
 
-	auto sd = subdomain(i);
+	auto sd = grid.subdomain(i);
 	i = i_;
 	auto d = sd.diagonal().eval();
 
@@ -933,14 +1069,14 @@ CubicLagrangeDiscreteGrid::determineShapeFunctions(int field_id, Vector3r const
 	auto c1 = (sd.max() + sd.min()).cwiseQuotient(denom).eval();
 	auto xi = (c0.cwiseProduct(x) - c1).eval();
 
-	cell = m_cells[field_id][i];
+	cell = field.cells ? field.cells[i] : denseCell(grid.resolution(), i);
 	N = shape_function_(xi, dN);
 	return true;
 }
 
 real
-CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const& xi, const std::array<int, 32> &cell, const Vector3r &c0, const Eigen::Matrix<real, 32, 1> &N,
-	Vector3r* gradient, Eigen::Matrix<real, 32, 3> *dN) const
+interpolate(FieldView const& field, std::array<int, 32> const& cell, Vector3r const& c0,
+	Eigen::Matrix<real, 32, 1> const& N, Vector3r* gradient, Eigen::Matrix<real, 32, 3>* dN)
 {
 	if (!gradient)
 	{
@@ -948,7 +1084,7 @@ CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const& xi, const s
 		for (auto j = 0; j < 32; ++j)
 		{
 			auto v = cell[j];
-			auto c = m_nodes[field_id][v];
+			auto c = field.nodes[v];
 			if (c == std::numeric_limits<real>::max())
 			{
 				return std::numeric_limits<real>::max();
@@ -964,7 +1100,7 @@ CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const& xi, const s
 	for (auto j = 0; j < 32; ++j)
 	{
 		auto v = cell[j];
-		auto c = m_nodes[field_id][v];
+		auto c = field.nodes[v];
 		if (c == std::numeric_limits<real>::max())
 		{
 			gradient->setZero();
@@ -981,25 +1117,25 @@ CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const& xi, const s
 }
 
 real
-CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const &x,
-									   Vector3r *gradient) const
+interpolate(DiscreteGrid const& grid, FieldView const& field, Vector3r const &x,
+	Vector3r *gradient)
 {
-	if (!m_domain.contains(x))
+	if (!grid.domain().contains(x))
 		return std::numeric_limits<real>::max();
 
-	auto mi = (x - m_domain.min()).cwiseProduct(m_inv_cell_size).cast<int>().eval();
-	if (mi[0] >= m_resolution[0])
-		mi[0] = m_resolution[0] - 1;
-	if (mi[1] >= m_resolution[1])
-		mi[1] = m_resolution[1] - 1;
-	if (mi[2] >= m_resolution[2])
-		mi[2] = m_resolution[2] - 1;
-	auto i = multiToSingleIndex({mi(0), mi(1), mi(2)});
-	auto i_ = m_cell_map[field_id][i];
+	auto mi = (x - grid.domain().min()).cwiseProduct(grid.invCellSize()).cast<int>().eval();
+	if (mi[0] >= grid.resolution()[0])
+		mi[0] = grid.resolution()[0] - 1;
+	if (mi[1] >= grid.resolution()[1])
+		mi[1] = grid.resolution()[1] - 1;
+	if (mi[2] >= grid.resolution()[2])
+		mi[2] = grid.resolution()[2] - 1;
+	auto i = grid.multiToSingleIndex({mi(0), mi(1), mi(2)});
+	auto i_ = field.cell_map[i];
 	if (i_ == std::numeric_limits<int>::max())
 		return std::numeric_limits<real>::max();
 
-	auto sd = subdomain(i);
+	auto sd = grid.subdomain(i);
 	i = i_;
 	auto d = sd.diagonal().eval();
 
@@ -1008,7 +1144,8 @@ CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const &x,
 	auto c1 = (sd.max() + sd.min()).cwiseQuotient(denom).eval();
 	auto xi = (c0.cwiseProduct(x) - c1).eval();
 
-	auto const &cell = m_cells[field_id][i];
+	auto implicit_cell = std::array<int, 32>{};
+	auto const &cell = field.cells ? field.cells[i] : (implicit_cell = denseCell(grid.resolution(), i));
 	if (!gradient)
 	{
 		//auto phi = m_coefficients[field_id][i].dot(shape_function_(xi, nullptr));
@@ -1017,7 +1154,7 @@ CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const &x,
 		for (auto j = 0; j < 32; ++j)
 		{
 			auto v = cell[j];
-			auto c = m_nodes[field_id][v];
+			auto c = field.nodes[v];
 			if (c == std::numeric_limits<real>::max())
 			{
 				return std::numeric_limits<real>::max();
@@ -1052,7 +1189,7 @@ CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const &x,
 	for (auto j = 0; j < 32; ++j)
 	{
 		auto v = cell[j];
-		auto c = m_nodes[field_id][v];
+		auto c = field.nodes[v];
 		if (c == std::numeric_limits<real>::max())
 		{
 			gradient->setZero();
@@ -1068,115 +1205,2015 @@ CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const &x,
 	return phi;
 }
 
-void CubicLagrangeDiscreteGrid::reduceField(int field_id, Predicate pred)
+}
+
+Vector3r
+CubicLagrangeDiscreteGrid::indexToNodePosition(int l) const
 {
-	auto &coeffs = m_nodes[field_id];
-	auto &cells = m_cells[field_id];
-	auto keep = std::vector<bool>(coeffs.size());
-	for (auto l = 0u; l < coeffs.size(); ++l)
+	auto x = Vector3r{};
+
+	auto& n = m_resolution;
+
+	auto nv = (n[0] + 1) * (n[1] + 1) * (n[2] + 1);
+	auto ne_x = (n[0] + 0) * (n[1] + 1) * (n[2] + 1);
+	auto ne_y = (n[0] + 1) * (n[1] + 0) * (n[2] + 1);
+	auto ne_z = (n[0] + 1) * (n[1] + 1) * (n[2] + 0);
+	auto ne = ne_x + ne_y + ne_z;
+
+	auto ijk = Matrix<int, 3, 1>{};
+	if (l < nv)
+	{
+		ijk(2) = l / ((n[1] + 1) * (n[0] + 1));
+		auto temp = l % ((n[1] + 1) * (n[0] + 1));
+		ijk(1) = temp / (n[0] + 1);
+		ijk(0) = temp % (n[0] + 1);
+
+		x = m_domain.min() + m_cell_size.cwiseProduct(ijk.cast<real>());
+	}
+	else if (l < nv + 2 * ne_x)
+	{
+		l -= nv;
+		auto e_ind = l / 2;
+		ijk(2) = e_ind / ((n[1] + 1) * n[0]);
+		auto temp = e_ind % ((n[1] + 1) * n[0]);
+		ijk(1) = temp / n[0];
+		ijk(0) = temp % n[0];
+
+		x = m_domain.min() + m_cell_size.cwiseProduct(ijk.cast<real>());
+		x(0) += (1.0 + static_cast<real>(l % 2)) / 3.0 * m_cell_size[0];
+	}
+	else if (l < nv + 2 * (ne_x + ne_y))
+	{
+		l -= (nv + 2 * ne_x);
+		auto e_ind = l / 2;
+		ijk(0) = e_ind / ((n[2] + 1) * n[1]);
+		auto temp = e_ind % ((n[2] + 1) * n[1]);
+		ijk(2) = temp / n[1];
+		ijk(1) = temp % n[1];
+
+		x = m_domain.min() + m_cell_size.cwiseProduct(ijk.cast<real>());
+		x(1) += (1.0 + static_cast<real>(l % 2)) / 3.0 * m_cell_size[1];
+	}
+	else
+	{
+		l -= (nv + 2 * (ne_x + ne_y));
+		auto e_ind = l / 2;
+		ijk(1) = e_ind / ((n[0] + 1) * n[2]);
+		auto temp = e_ind % ((n[0] + 1) * n[2]);
+		ijk(0) = temp / n[2];
+		ijk(2) = temp % n[2];
+
+		x = m_domain.min() + m_cell_size.cwiseProduct(ijk.cast<real>());
+		x(2) += (1.0 + static_cast<real>(l % 2)) / 3.0 * m_cell_size[2];
+	}
+
+	return x;
+}
+
+int
+CubicLagrangeDiscreteGrid::latticeToNodeIndex(MultiIndex const& ijk) const
+{
+	auto& n = m_resolution;
+
+	auto nv = (n[0] + 1) * (n[1] + 1) * (n[2] + 1);
+	auto ne_x = (n[0] + 0) * (n[1] + 1) * (n[2] + 1);
+	auto ne_y = (n[0] + 1) * (n[1] + 0) * (n[2] + 1);
+
+	auto i = ijk[0] / 3;
+	auto j = ijk[1] / 3;
+	auto k = ijk[2] / 3;
+
+	if (ijk[0] % 3 != 0)
+		return nv + 2 * (n[0] * (n[1] + 1) * k + n[0] * j + i) + ijk[0] % 3 - 1;
+	if (ijk[1] % 3 != 0)
+		return nv + 2 * ne_x + 2 * (n[1] * (n[2] + 1) * i + n[1] * k + j) + ijk[1] % 3 - 1;
+	if (ijk[2] % 3 != 0)
+		return nv + 2 * (ne_x + ne_y) + 2 * (n[2] * (n[0] + 1) * j + n[2] * i + k) + ijk[2] % 3 - 1;
+	return (n[0] + 1) * (n[1] + 1) * k + (n[0] + 1) * j + i;
+}
+
+Vector3r
+CubicLagrangeDiscreteGrid::latticeToNodePosition(MultiIndex const& ijk) const
+{
+	auto x = (m_domain.min() + m_cell_size.cwiseProduct((ijk / 3).cast<real>())).eval();
+	for (auto d = 0; d < 3; ++d)
+	{
+		if (ijk[d] % 3 != 0)
+			x(d) += static_cast<real>(ijk[d] % 3) / 3.0 * m_cell_size[d];
+	}
+	return x;
+}
+
+CubicLagrangeDiscreteGrid::CubicLagrangeDiscreteGrid(std::string const &filename)
+{
+	load(filename);
+}
+
+CubicLagrangeDiscreteGrid::CubicLagrangeDiscreteGrid(std::string const &filename,
+													 std::vector<bool> const &field_mask)
+{
+	load(filename, field_mask);
+}
+
+CubicLagrangeDiscreteGrid::CubicLagrangeDiscreteGrid(AlignedBox3r const &domain,
+													 Eigen::Vector3i const &resolution)
+	: DiscreteGrid(domain, resolution)
+{
+}
+
+CubicLagrangeDiscreteGrid::CubicLagrangeDiscreteGrid(const AlignedBox3r& minimum_domain,
+                                                     const Vector3r& cell_size)
+    : DiscreteGrid(minimum_domain, cell_size)
+{
+}
+
+bool CubicLagrangeDiscreteGrid::parseFileFormat(std::string const& name, FileFormat& format)
+{
+	if (name == "legacy")
+		format = FileFormat::Legacy;
+	else if (name == "mappable")
+		format = FileFormat::Mappable;
+	else if (name == "compressed")
+		format = FileFormat::Compressed;
+	else
+		return false;
+	return true;
+}
+
+void CubicLagrangeDiscreteGrid::save(std::string const &filename) const
+{
+	save(filename, FileFormat::Legacy);
+}
+
+void CubicLagrangeDiscreteGrid::save(std::string const &filename, FileFormat format) const
+{
+	// Pending fields have to be read before the file is overwritten.
+	requireAllFields();
+
+	auto out = std::ofstream(filename, std::ios::binary);
+	save(*out.rdbuf(), format);
+	out.close();
+}
+
+void CubicLagrangeDiscreteGrid::save(std::ostream &out, FileFormat format) const
+{
+	save(*out.rdbuf(), format);
+}
+
+void CubicLagrangeDiscreteGrid::save(std::streambuf &buf, FileFormat format) const
+{
+	requireAllFields();
+
+	switch (format)
+	{
+	case FileFormat::Legacy:
+		saveLegacy(buf);
+		break;
+	case FileFormat::Mappable:
+		saveSectioned(buf, false);
+		break;
+	case FileFormat::Compressed:
+		saveSectioned(buf, true);
+		break;
+	}
+}
+
+void CubicLagrangeDiscreteGrid::saveLegacy(std::streambuf &buf) const
+{
+	serialize::write(buf, m_domain);
+	serialize::write(buf, m_resolution);
+	serialize::write(buf, m_cell_size);
+	serialize::write(buf, m_inv_cell_size);
+	serialize::write(buf, m_n_cells);
+	serialize::write(buf, m_n_fields);
+
+	serialize::write(buf, m_nodes.size());
+	for (auto const &nodes : m_nodes)
+	{
+		serialize::write(buf, nodes);
+	}
+
+	serialize::write(buf, m_cells.size());
+	for (auto i = 0u; i < m_cells.size(); ++i)
+	{
+		if (!hasImplicitCells(i))
+		{
+			serialize::write(buf, m_cells[i]);
+			continue;
+		}
+
+		// The legacy format stores the cells of all fields.
+		auto cells = std::vector<std::array<int, 32>>(m_n_cells);
+#pragma omp parallel for schedule(static)
+		for (int l = 0; l < static_cast<int>(m_n_cells); ++l)
+			cells[l] = denseCell(l);
+		serialize::write(buf, cells);
+	}
+
+	serialize::write(buf, m_cell_map.size());
+	for (auto const &maps : m_cell_map)
+	{
+		serialize::write(buf, maps.toDense());
+	}
+}
+
+void CubicLagrangeDiscreteGrid::saveSectioned(std::streambuf &buf, bool compressed) const
+{
+	auto header = grid_file::Header{};
+	std::copy(grid_file::magic, grid_file::magic + 8, header.magic);
+	header.version = grid_file::version;
+	header.real_size = sizeof(real);
+	for (auto d = 0; d < 3; ++d)
+	{
+		header.domain_min[d] = m_domain.min()[d];
+		header.domain_max[d] = m_domain.max()[d];
+		header.cell_size[d] = m_cell_size[d];
+		header.inv_cell_size[d] = m_inv_cell_size[d];
+		header.resolution[d] = m_resolution[d];
+	}
+	header.compression = compressed ? grid_file::compressed : grid_file::uncompressed;
+	header.n_cells = m_n_cells;
+	header.n_fields = m_nodes.size();
+
+	auto writer = SectionWriter(m_nodes.size(), compressed);
+	auto entries = std::vector<grid_file::FieldEntry>(m_nodes.size());
+	for (auto i = 0u; i < m_nodes.size(); ++i)
+	{
+		auto& entry = entries[i];
+		entry = grid_file::FieldEntry{};
+		entry.nodes = writer.add(m_nodes[i].data(), m_nodes[i].size());
+
+		// Only the cells that are not implied by the grid are stored.
+		auto cell_map = m_cell_map[i].view();
+		entry.identity = cell_map.isIdentity();
+		if (!hasImplicitCells(i))
+			entry.cells = writer.add(reinterpret_cast<int const*>(m_cells[i].data()), m_cells[i].size(), 32u);
+		if (!cell_map.isIdentity())
+		{
+			auto n_blocks = static_cast<std::size_t>(cell_map.nBlocks());
+			entry.masks = writer.add(cell_map.masks(), n_blocks);
+			entry.block_offsets = writer.add(cell_map.offsets(), n_blocks + 1u);
+			entry.cell_list = writer.add(cell_map.cells(), static_cast<std::size_t>(cell_map.offsets()[n_blocks]));
+		}
+	}
+
+	writer.write(buf, header, entries);
+}
+
+void CubicLagrangeDiscreteGrid::load(std::string const &filename)
+{
+	loadFields(filename, nullptr);
+}
+
+void CubicLagrangeDiscreteGrid::load(std::string const &filename, std::vector<bool> const &field_mask)
+{
+	loadFields(filename, &field_mask);
+}
+
+void CubicLagrangeDiscreteGrid::loadFields(std::string const &filename, std::vector<bool> const *field_mask)
+{
+	m_pending_fields = PendingFields{};
+
+	auto in = std::ifstream(filename, std::ios::binary);
+
+	if (!in.good())
+	{
+		std::cerr << "ERROR: Discrete grid can not be loaded. Input file does not exist!" << std::endl;
+		return;
+	}
+
+	auto magic = std::array<char, 8>{};
+	if (serialize::read(*in.rdbuf(), magic) &&
+		std::equal(magic.begin(), magic.end(), grid_file::magic))
+	{
+		in.close();
+		auto file = std::make_shared<MappedFile>(filename);
+		if (!file->data)
+		{
+			std::cerr << "ERROR: Discrete grid can not be loaded. Input file can not be mapped!" << std::endl;
+			return;
+		}
+		loadSectioned(file->data, file->size, file, field_mask);
+		return;
+	}
+	in.seekg(0);
+
+	serialize::read(*in.rdbuf(), m_domain);
+	loadLegacy(*in.rdbuf(), filename, field_mask);
+	in.close();
+}
+
+void CubicLagrangeDiscreteGrid::load(std::istream &in)
+{
+	load(*in.rdbuf());
+}
+
+void CubicLagrangeDiscreteGrid::load(std::streambuf &buf)
+{
+	m_pending_fields = PendingFields{};
+
+	auto header = grid_file::Header{};
+	auto n_read = static_cast<std::size_t>(buf.sgetn(header.magic, sizeof(header.magic)));
+	if (n_read < sizeof(header.magic) ||
+		!std::equal(header.magic, header.magic + sizeof(header.magic), grid_file::magic))
+	{
+		// The bytes read belong to the domain of a grid in the legacy format.
+		auto domain = std::array<char, sizeof(AlignedBox3r)>{};
+		std::copy(header.magic, header.magic + n_read, domain.begin());
+		buf.sgetn(domain.data() + n_read, static_cast<std::streamsize>(domain.size() - n_read));
+		auto domain_buf = MemoryBuffer(domain.data(), domain.size());
+		serialize::read(domain_buf, m_domain);
+		loadLegacy(buf, std::string(), nullptr);
+		return;
+	}
+
+	// The sections are addressed by their offsets, hence the grid is read into
+	// memory as a whole. Its size is only trusted if the directory is intact;
+	// otherwise the header and the directory are passed on to report the error.
+	auto data = std::vector<char>(sizeof(header));
+	buf.sgetn(reinterpret_cast<char*>(&header) + sizeof(header.magic),
+		static_cast<std::streamsize>(sizeof(header) - sizeof(header.magic)));
+	auto entries = std::vector<grid_file::FieldEntry>{};
+	auto entry = grid_file::FieldEntry{};
+	while (header.version == grid_file::version && entries.size() < header.n_fields &&
+		buf.sgetn(reinterpret_cast<char*>(&entry), sizeof(entry)) == sizeof(entry))
+		entries.push_back(entry);
+	std::memcpy(data.data(), &header, sizeof(header));
+	data.insert(data.end(), reinterpret_cast<char const*>(entries.data()),
+		reinterpret_cast<char const*>(entries.data() + entries.size()));
+
+	if (entries.size() == header.n_fields && grid_file::directoryChecksum(header, entries) == header.directory_checksum)
+	{
+		auto end = static_cast<uint64_t>(data.size());
+		for (auto const& e : entries)
+		{
+			for (auto const* section : {&e.nodes, &e.cells, &e.masks, &e.block_offsets, &e.cell_list})
+				end = std::max(end, section->offset + section->size);
+		}
+		auto n_directory = data.size();
+		data.resize(static_cast<std::size_t>(end));
+		data.resize(n_directory + static_cast<std::size_t>(
+			buf.sgetn(data.data() + n_directory, static_cast<std::streamsize>(end - n_directory))));
+	}
+	loadSectioned(data.data(), data.size(), nullptr, nullptr);
+}
+
+void CubicLagrangeDiscreteGrid::loadFromMemory(void const *data, std::size_t size)
+{
+	loadBuffer(static_cast<char const*>(data), size);
+}
+
+bool CubicLagrangeDiscreteGrid::loadBuffer(char const *data, std::size_t size)
+{
+	m_pending_fields = PendingFields{};
+
+	if (size >= 8u && std::equal(data, data + 8, grid_file::magic))
+		return loadSectioned(data, size, nullptr, nullptr);
+
+	auto buf = MemoryBuffer(data, size);
+	serialize::read(buf, m_domain);
+	return loadLegacy(buf, std::string(), nullptr);
+}
+
+AsyncTask<bool>
+CubicLagrangeDiscreteGrid::loadAsync(std::string const &filename, Executor const &executor)
+{
+	if (!executor || !isReady())
+	{
+		std::cerr << "ERROR: Discrete grid can not be loaded. " <<
+			(executor ? "Another task is running on the grid!" : "No executor given!") << std::endl;
+		return AsyncTask<bool>::finished(TaskStatus::Failed, false);
+	}
+
+	auto state = std::make_shared<AsyncTask<bool>::State>(false);
+	m_task = state;
+	executor([this, filename, state]()
+	{
+		// The file is read in chunks to report the progress and to respond to
+		// cancellation, where reading takes most of the time.
+		auto in = std::ifstream(filename, std::ios::binary | std::ios::ate);
+		if (!in.good())
+		{
+			std::cerr << "ERROR: Discrete grid can not be loaded. Input file does not exist!" << std::endl;
+			state->finish(TaskStatus::Failed, false);
+			return;
+		}
+		auto data = std::vector<char>(static_cast<std::size_t>(in.tellg()));
+		in.seekg(0);
+		auto const chunk_size = std::size_t{1} << 24;
+		for (auto offset = std::size_t{0}; offset < data.size(); offset += chunk_size)
+		{
+			if (state->isCancelled())
+			{
+				state->finish(TaskStatus::Cancelled, false);
+				return;
+			}
+			auto n_chunk = std::min(chunk_size, data.size() - offset);
+			if (!in.read(data.data() + offset, static_cast<std::streamsize>(n_chunk)))
+			{
+				std::cerr << "ERROR: Discrete grid can not be loaded. Input file can not be read!" << std::endl;
+				state->finish(TaskStatus::Failed, false);
+				return;
+			}
+			state->setProgress(static_cast<real>(0.9) * static_cast<real>(offset + n_chunk) / static_cast<real>(data.size()));
+		}
+		in.close();
+
+		auto grid = CubicLagrangeDiscreteGrid{};
+		if (!grid.loadBuffer(data.data(), data.size()))
+		{
+			state->finish(TaskStatus::Failed, false);
+			return;
+		}
+		data = std::vector<char>{};
+		if (state->isCancelled())
+		{
+			state->finish(TaskStatus::Cancelled, false);
+			return;
+		}
+
+		// Queries are rejected until the task has finished, hence the data can be
+		// replaced. The task itself is kept.
+		static_cast<DiscreteGrid&>(*this) = grid;
+		m_nodes = std::move(grid.m_nodes);
+		m_cells = std::move(grid.m_cells);
+		m_cell_map = std::move(grid.m_cell_map);
+		m_pending_fields = PendingFields{};
+		state->setProgress(1.0);
+		state->finish(TaskStatus::Done, true);
+	});
+	return AsyncTask<bool>(state);
+}
+
+bool CubicLagrangeDiscreteGrid::loadLegacy(std::streambuf &buf, std::string const &filename,
+	std::vector<bool> const *field_mask)
+{
+	serialize::read(buf, m_resolution);
+	serialize::read(buf, m_cell_size);
+	serialize::read(buf, m_inv_cell_size);
+	serialize::read(buf, m_n_cells);
+	serialize::read(buf, m_n_fields);
+
+	// The arrays of the fields that are not read now are skipped, where their
+	// positions are recorded to read them on first use.
+	auto read_now = [&](std::size_t i) { return !field_mask || (i < field_mask->size() && (*field_mask)[i]); };
+	auto position = [&]() { return buf.pubseekoff(0, std::ios::cur, std::ios::in); };
+	auto valid = true;
+
+	auto n_nodes = std::size_t{};
+	valid = serialize::read(buf, n_nodes) && arrays_fit(buf, 3u * n_nodes);
+	m_nodes.assign(valid ? n_nodes : 0u, {});
+	auto node_positions = std::vector<std::streamoff>(m_nodes.size());
+	for (auto i = 0u; i < m_nodes.size() && valid; ++i)
+	{
+		node_positions[i] = position();
+		valid = read_or_skip(buf, read_now(i), m_nodes[i]);
+	}
+
+	auto n_cells = std::size_t{};
+	valid = valid && serialize::read(buf, n_cells) && n_cells == n_nodes;
+	m_cells.assign(valid ? n_cells : 0u, {});
+	auto cell_positions = std::vector<std::streamoff>(m_cells.size());
+	for (auto i = 0u; i < m_cells.size() && valid; ++i)
+	{
+		cell_positions[i] = position();
+		valid = read_or_skip(buf, read_now(i), m_cells[i]);
+	}
+
+	auto n_cell_maps = std::size_t{};
+	valid = valid && serialize::read(buf, n_cell_maps) && n_cell_maps == n_nodes;
+	m_cell_map.assign(valid ? n_cell_maps : 0u, CellMap{});
+	auto cell_map_positions = std::vector<std::streamoff>(m_cell_map.size());
+	auto cell_map = std::vector<int>{};
+	for (auto i = 0u; i < m_cell_map.size() && valid; ++i)
+	{
+		cell_map_positions[i] = position();
+		valid = read_or_skip(buf, read_now(i), cell_map);
+		if (valid && read_now(i))
+		{
+			valid = cell_map.size() == m_n_cells;
+			m_cell_map[i] = CellMap(m_resolution, cell_map);
+		}
+	}
+
+	if (!valid)
+	{
+		std::cerr << "ERROR: Discrete grid can not be loaded. Input file is corrupted!" << std::endl;
+		m_nodes.clear();
+		m_cells.clear();
+		m_cell_map.clear();
+		m_n_fields = 0u;
+		return false;
+	}
+
+	auto pending = std::vector<bool>(m_nodes.size());
+	for (auto i = 0u; i < pending.size(); ++i)
+	{
+		pending[i] = !read_now(i);
+		if (!pending[i])
+			releaseDenseCells(i);
+	}
+	auto resolution = m_resolution;
+	auto n_grid_cells = m_n_cells;
+	setPendingFields([=](int i, std::vector<real>& nodes, std::vector<std::array<int, 32>>& cells, CellMap& cell_map)
+	{
+		auto file = std::ifstream(filename, std::ios::binary);
+		auto dense_cell_map = std::vector<int>{};
+		auto valid =
+			file.rdbuf()->pubseekpos(node_positions[i], std::ios::in) == node_positions[i] &&
+			serialize::read(*file.rdbuf(), nodes) &&
+			file.rdbuf()->pubseekpos(cell_positions[i], std::ios::in) == cell_positions[i] &&
+			serialize::read(*file.rdbuf(), cells) &&
+			file.rdbuf()->pubseekpos(cell_map_positions[i], std::ios::in) == cell_map_positions[i] &&
+			serialize::read(*file.rdbuf(), dense_cell_map) && dense_cell_map.size() == n_grid_cells;
+		if (valid)
+			cell_map = CellMap(resolution, dense_cell_map);
+		return valid;
+	}, pending);
+	return true;
+}
+
+bool CubicLagrangeDiscreteGrid::loadSectioned(char const *data, std::size_t size,
+	std::shared_ptr<void const> const &owner, std::vector<bool> const *field_mask)
+{
+	auto header = grid_file::Header{};
+	auto entries = std::vector<grid_file::FieldEntry>{};
+	if (!grid_file::readDirectory(data, size, header, entries))
+		return false;
+
+	read_geometry(header, m_domain, m_resolution, m_cell_size, m_inv_cell_size);
+	m_n_cells = header.n_cells;
+	m_n_fields = header.n_fields;
+
+	m_nodes.assign(m_n_fields, {});
+	m_cells.assign(m_n_fields, {});
+	m_cell_map.assign(m_n_fields, CellMap{});
+
+	auto compressed = header.compression == grid_file::compressed;
+	auto read_now = [&](std::size_t i) { return !field_mask || (i < field_mask->size() && (*field_mask)[i]); };
+	auto valid = true;
+	auto pending = std::vector<bool>(m_n_fields);
+	for (auto i = 0u; i < m_n_fields && valid; ++i)
+	{
+		pending[i] = !read_now(i);
+		if (!pending[i])
+		{
+			valid = read_field(data, entries[i], compressed, m_resolution, m_n_cells,
+				m_nodes[i], m_cells[i], m_cell_map[i]);
+			if (valid)
+				releaseDenseCells(i);
+		}
+	}
+
+	if (!valid)
+	{
+		std::cerr << "ERROR: Discrete grid can not be loaded. Input file is corrupted!" << std::endl;
+		m_nodes.clear();
+		m_cells.clear();
+		m_cell_map.clear();
+		m_n_fields = 0u;
+		return false;
+	}
+
+	// The data is kept alive by its owner until all pending fields have been read.
+	auto resolution = m_resolution;
+	auto n_cells = m_n_cells;
+	setPendingFields([=](int i, std::vector<real>& nodes, std::vector<std::array<int, 32>>& cells, CellMap& cell_map)
+	{
+		static_cast<void>(owner);
+		return read_field(data, entries[i], compressed, resolution, n_cells, nodes, cells, cell_map);
+	}, pending);
+	return true;
+}
+
+CubicLagrangeDiscreteGrid::PendingFields::PendingFields(PendingFields const& other)
+	: reader(other.reader), n_fields(other.n_fields), n_pending(other.n_pending)
+{
+	if (n_fields > 0u)
+	{
+		pending.reset(new std::atomic<bool>[n_fields]);
+		for (auto i = 0u; i < n_fields; ++i)
+			pending[i].store(other.pending[i].load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+}
+
+CubicLagrangeDiscreteGrid::PendingFields&
+CubicLagrangeDiscreteGrid::PendingFields::operator=(PendingFields const& other)
+{
+	if (this != &other)
+	{
+		auto copy = PendingFields(other);
+		reader = std::move(copy.reader);
+		n_fields = copy.n_fields;
+		n_pending = copy.n_pending;
+		pending = std::move(copy.pending);
+	}
+	return *this;
+}
+
+void
+CubicLagrangeDiscreteGrid::setPendingFields(FieldReader const& reader, std::vector<bool> const& pending)
+{
+	m_pending_fields = PendingFields{};
+	auto n_pending = static_cast<std::size_t>(std::count(pending.begin(), pending.end(), true));
+	if (n_pending == 0u)
+		return;
+
+	m_pending_fields.reader = reader;
+	m_pending_fields.n_fields = pending.size();
+	m_pending_fields.n_pending = n_pending;
+	m_pending_fields.pending.reset(new std::atomic<bool>[pending.size()]);
+	for (auto i = 0u; i < pending.size(); ++i)
+		m_pending_fields.pending[i].store(pending[i], std::memory_order_relaxed);
+}
+
+void
+CubicLagrangeDiscreteGrid::loadPendingField(int field_id) const
+{
+	std::lock_guard<std::mutex> lock(*m_pending_fields.mutex);
+	if (!m_pending_fields.isPending(field_id))
+		return;
+
+	// Reading a field does not change the observable state of the grid, hence
+	// pending fields are read by const member functions as well.
+	auto& self = const_cast<CubicLagrangeDiscreteGrid&>(*this);
+	auto& nodes = self.m_nodes[field_id];
+	auto& cells = self.m_cells[field_id];
+	auto& cell_map = self.m_cell_map[field_id];
+	if (!m_pending_fields.reader(field_id, nodes, cells, cell_map))
+	{
+		std::cerr << "ERROR: Field " << field_id << " of discrete grid can not be loaded. Input file is corrupted!" << std::endl;
+		nodes.clear();
+		cells.clear();
+		cell_map = CellMap(m_resolution, std::vector<char>(m_n_cells, 0));
+	}
+	else
+		self.releaseDenseCells(field_id);
+
+	m_pending_fields.pending[field_id].store(false, std::memory_order_release);
+	// Release the file once all fields have been read.
+	if (--m_pending_fields.n_pending == 0u)
+		m_pending_fields.reader = nullptr;
+}
+
+void
+CubicLagrangeDiscreteGrid::requireAllFields() const
+{
+	for (auto i = 0u; i < m_pending_fields.n_fields; ++i)
+		requireField(static_cast<int>(i));
+}
+
+int
+CubicLagrangeDiscreteGrid::addFunction(ContinuousFunction const &func, bool verbose,
+									   SamplePredicate const &pred)
+{
+	using namespace std::chrono;
+
+	auto t0_construction = high_resolution_clock::now();
+
+	auto& n = m_resolution;
+
+	auto nv = (n[0] + 1) * (n[1] + 1) * (n[2] + 1);
+	auto ne_x = (n[0] + 0) * (n[1] + 1) * (n[2] + 1);
+	auto ne_y = (n[0] + 1) * (n[1] + 0) * (n[2] + 1);
+	auto ne_z = (n[0] + 1) * (n[1] + 1) * (n[2] + 0);
+	auto ne = ne_x + ne_y + ne_z;
+
+	auto n_nodes = nv + 2 * ne;
+
+	m_nodes.push_back({});
+	auto &coeffs = m_nodes.back();
+	coeffs.resize(n_nodes);
+
+	std::atomic_int counter(0);
+	SpinLock mutex;
+	auto t0 = high_resolution_clock::now();
+
+#pragma omp parallel default(shared)
+	{
+#pragma omp for schedule(static) nowait
+		for (int l = 0; l < static_cast<int>(n_nodes); ++l)
+		{
+			auto x = indexToNodePosition(l);
+			auto &c = coeffs[l];
+
+			if (!pred || pred(x))
+				c = func(x);
+			else
+				c = std::numeric_limits<real>::max();
+
+			if (verbose && (++counter == n_nodes || duration_cast<milliseconds>(high_resolution_clock::now() - t0).count() > 1000))
+			{
+				std::async(std::launch::async, [&]() {
+					mutex.lock();
+					t0 = high_resolution_clock::now();
+					std::cout << "\r"
+							  << "Construction " << std::setw(20)
+							  << 100.0 * static_cast<real>(counter) / static_cast<real>(n_nodes) << "%";
+					mutex.unlock();
+				});
+			}
+		}
+	}
+
+	finalizeDenseField();
+
+	if (verbose)
+	{
+		std::cout << "\rConstruction took " << std::setw(15) << static_cast<real>(duration_cast<milliseconds>(high_resolution_clock::now() - t0_construction).count()) / 1000.0 << "s" << std::endl;
+	}
+
+	return static_cast<int>(m_n_fields - 1);
+}
+
+AsyncTask<int>
+CubicLagrangeDiscreteGrid::addFunctionAsync(ContinuousFunction const &func, Executor const &executor,
+	SamplePredicate const &pred)
+{
+	if (!executor || !isReady())
+	{
+		std::cerr << "ERROR: Function can not be discretized. " <<
+			(executor ? "Another task is running on the grid!" : "No executor given!") << std::endl;
+		return AsyncTask<int>::finished(TaskStatus::Failed, -1);
+	}
+
+	auto state = std::make_shared<AsyncTask<int>::State>(-1);
+	m_task = state;
+	executor([this, func, pred, state]()
+	{
+		auto& n = m_resolution;
+		auto n_nodes = (n[0] + 1) * (n[1] + 1) * (n[2] + 1)
+			+ 2 * ((n[0] + 0) * (n[1] + 1) * (n[2] + 1)
+			+ (n[0] + 1) * (n[1] + 0) * (n[2] + 1)
+			+ (n[0] + 1) * (n[1] + 1) * (n[2] + 0));
+
+		auto coeffs = std::vector<real>(n_nodes);
+		std::atomic_int counter(0);
+		auto progress_step = std::max(n_nodes / 100, 1);
+
+		// The remaining nodes are skipped once the task has been cancelled.
+#pragma omp parallel for schedule(static)
+		for (int l = 0; l < n_nodes; ++l)
+		{
+			if (state->isCancelled())
+				continue;
+
+			auto x = indexToNodePosition(l);
+			coeffs[l] = !pred || pred(x) ? func(x) : std::numeric_limits<real>::max();
+
+			if (++counter % progress_step == 0)
+				state->setProgress(static_cast<real>(counter) / static_cast<real>(n_nodes));
+		}
+
+		if (state->isCancelled())
+		{
+			state->finish(TaskStatus::Cancelled, -1);
+			return;
+		}
+
+		// Queries are rejected until the task has finished.
+		m_nodes.push_back(std::move(coeffs));
+		auto field_id = finalizeDenseField();
+		state->setProgress(1.0);
+		state->finish(TaskStatus::Done, field_id);
+	});
+	return AsyncTask<int>(state);
+}
+
+int
+CubicLagrangeDiscreteGrid::addSparseFunction(ContinuousFunction const& func, CellPredicate const& keep_cell,
+	bool verbose)
+{
+	using namespace std::chrono;
+
+	auto t0_construction = high_resolution_clock::now();
+
+	auto& n = m_resolution;
+	auto n_dense_nodes = static_cast<int64_t>(n[0] + 1) * (n[1] + 1) * (n[2] + 1)
+		+ 2 * (static_cast<int64_t>(n[0] + 0) * (n[1] + 1) * (n[2] + 1)
+		+ static_cast<int64_t>(n[0] + 1) * (n[1] + 0) * (n[2] + 1)
+		+ static_cast<int64_t>(n[0] + 1) * (n[1] + 1) * (n[2] + 0));
+	if (n_dense_nodes > std::numeric_limits<int>::max())
+	{
+		std::cerr << "ERROR: Function can not be discretized. The number of nodes exceeds the index range!" << std::endl;
+		return -1;
+	}
+
+	auto keep = std::vector<char>(m_n_cells);
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(m_n_cells); ++l)
+		keep[l] = keep_cell(subdomain(l));
+	auto cell_map = CellMap(m_resolution, keep);
+	auto n_cells = static_cast<int>(std::count_if(keep.begin(), keep.end(), [](char k) { return k != 0; }));
+
+	// Each node is collected by the remaining cell with the smallest index among the
+	// cells containing it. Cells are visited in the order of their indices.
+	auto is_owner = [&](MultiIndex const& node, int l)
+	{
+		auto lower = MultiIndex{};
+		auto upper = MultiIndex{};
+		for (auto d = 0; d < 3; ++d)
+		{
+			lower[d] = node[d] % 3 == 0 ? std::max(node[d] / 3 - 1, 0) : node[d] / 3;
+			upper[d] = std::min(node[d] / 3, n[d] - 1);
+		}
+		for (auto k = lower[2]; k <= upper[2]; ++k)
+			for (auto j = lower[1]; j <= upper[1]; ++j)
+				for (auto i = lower[0]; i <= upper[0]; ++i)
+				{
+					auto m = multiToSingleIndex({i, j, k});
+					if (keep[m])
+						return m == l;
+				}
+		return false;
+	};
+	auto cell_node = [&](int l, int j)
+	{
+		return (3 * singleToMultiIndex(l) + MultiIndex{lattice_offset(j, 0), lattice_offset(j, 1), lattice_offset(j, 2)}).eval();
+	};
+
+	auto node_offsets = std::vector<int>(n_cells + 1, 0);
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(m_n_cells); ++l)
+	{
+		if (!keep[l])
+			continue;
+		auto n_owned = 0;
+		for (auto j = 0; j < 32; ++j)
+			n_owned += is_owner(cell_node(l, j), l);
+		node_offsets[cell_map[l] + 1] = n_owned;
+	}
+	std::partial_sum(node_offsets.begin(), node_offsets.end(), node_offsets.begin());
+
+	// Sort the nodes along a z-curve, where ties are broken by the node index as in reduceField.
+	auto z_key = [&](int v)
+	{
+		return std::make_pair(zValue(indexToNodePosition(v), 4.0 * m_inv_cell_size.minCoeff()), v);
+	};
+	auto sort_pattern = std::vector<std::pair<uint64_t, int>>(node_offsets.back());
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(m_n_cells); ++l)
+	{
+		if (!keep[l])
+			continue;
+		auto o = node_offsets[cell_map[l]];
+		for (auto j = 0; j < 32; ++j)
+		{
+			auto node = cell_node(l, j);
+			if (is_owner(node, l))
+				sort_pattern[o++] = z_key(latticeToNodeIndex(node));
+		}
+	}
+	node_offsets = std::vector<int>{};
+	parallel_sort(sort_pattern);
+
+	m_nodes.push_back(std::vector<real>(sort_pattern.size()));
+	auto& coeffs = m_nodes.back();
+#pragma omp parallel for schedule(dynamic, 64)
+	for (int i = 0; i < static_cast<int>(coeffs.size()); ++i)
+		coeffs[i] = func(indexToNodePosition(sort_pattern[i].second));
+
+	m_cells.push_back(std::vector<std::array<int, 32>>(n_cells));
+	auto& cells = m_cells.back();
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(m_n_cells); ++l)
+	{
+		if (!keep[l])
+			continue;
+
+		auto& cell = cells[cell_map[l]];
+		cell = denseCell(l);
+		for (auto& v : cell)
+			v = static_cast<int>(std::lower_bound(sort_pattern.begin(), sort_pattern.end(), z_key(v)) - sort_pattern.begin());
+	}
+	m_cell_map.push_back(std::move(cell_map));
+
+	if (verbose)
+	{
+		std::cout << "Construction took " << std::setw(15) << static_cast<real>(duration_cast<milliseconds>(high_resolution_clock::now() - t0_construction).count()) / 1000.0 << "s" << std::endl;
+	}
+
+	return static_cast<int>(m_n_fields++);
+}
+
+int
+CubicLagrangeDiscreteGrid::finalizeDenseField()
+{
+	// The cells are implied by the grid.
+	m_cells.push_back({});
+	m_cell_map.push_back(CellMap(m_resolution));
+
+	return static_cast<int>(m_n_fields++);
+}
+
+std::array<int, 32>
+CubicLagrangeDiscreteGrid::denseCell(int l) const
+{
+	return cubic_lagrange::denseCell(m_resolution, l);
+}
+
+void
+CubicLagrangeDiscreteGrid::releaseDenseCells(int field_id)
+{
+	auto& cells = m_cells[field_id];
+	if (cells.size() != m_n_cells || !m_cell_map[field_id].isIdentity())
+		return;
+
+	auto n_mismatches = 0;
+#pragma omp parallel for schedule(static) reduction(+:n_mismatches)
+	for (int l = 0; l < static_cast<int>(m_n_cells); ++l)
+		n_mismatches += cells[l] != denseCell(l);
+	if (n_mismatches == 0)
+		cells = std::vector<std::array<int, 32>>{};
+}
+
+int
+CubicLagrangeDiscreteGrid::addNarrowBandDistance(MeshDistance const& md, real band_width, bool verbose)
+{
+	using namespace std::chrono;
+
+	auto t0_construction = high_resolution_clock::now();
+
+	auto const& mesh = *md.mesh();
+	auto& n = m_resolution;
+
+	auto nv = (n[0] + 1) * (n[1] + 1) * (n[2] + 1);
+	auto ne_x = (n[0] + 0) * (n[1] + 1) * (n[2] + 1);
+	auto ne_y = (n[0] + 1) * (n[1] + 0) * (n[2] + 1);
+	auto ne_z = (n[0] + 1) * (n[1] + 1) * (n[2] + 0);
+	auto ne = ne_x + ne_y + ne_z;
+
+	auto n_nodes = nv + 2 * ne;
+
+	m_nodes.push_back({});
+	auto &coeffs = m_nodes.back();
+	coeffs.assign(n_nodes, std::numeric_limits<real>::max());
+	auto nearest_face = std::vector<int>(n_nodes, -1);
+
+	// Partition the node lattice into slabs along z. Each slab is exclusively
+	// processed by one thread, hence the min-reduction per node is free of
+	// write conflicts.
+	auto lattice_res = (3 * n.array() + 1).matrix().eval();
+	auto h = (m_cell_size / 3.0).eval();
+	auto n_slabs = std::min(lattice_res[2], 8 * omp_get_max_threads());
+	auto slab_size = (lattice_res[2] + n_slabs - 1) / n_slabs;
+	n_slabs = (lattice_res[2] + slab_size - 1) / slab_size;
+
+	// Bin the lattice ranges of the triangle bounding boxes enlarged by the
+	// band width into the slabs.
+	auto n_faces = static_cast<int>(mesh.nFaces());
+	auto face_ranges = std::vector<std::array<MultiIndex, 2>>(n_faces);
+	auto slab_faces = std::vector<std::vector<int>>(n_slabs);
+	for (auto f = 0; f < n_faces; ++f)
+	{
+		auto box = AlignedBox3r{};
+		for (auto j = 0; j < 3; ++j)
+			box.extend(mesh.vertex(mesh.faceVertex(f, j)));
+
+		auto lo = (box.min() - Vector3r::Constant(band_width) - m_domain.min()).cwiseQuotient(h).array().ceil().eval();
+		auto hi = (box.max() + Vector3r::Constant(band_width) - m_domain.min()).cwiseQuotient(h).array().floor().eval();
+		if ((hi < 0.0).any() || (lo > (lattice_res.array() - 1).cast<real>()).any())
+			continue;
+
+		auto& range = face_ranges[f];
+		range[0] = lo.max(0.0).cast<int>().matrix();
+		range[1] = hi.cast<int>().min(lattice_res.array() - 1).matrix();
+		for (auto s = range[0][2] / slab_size; s <= range[1][2] / slab_size; ++s)
+			slab_faces[s].push_back(f);
+	}
+
+	auto band_width2 = band_width * band_width;
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int s = 0; s < n_slabs; ++s)
+	{
+		auto k_begin = s * slab_size;
+		auto k_end = std::min(k_begin + slab_size, lattice_res[2]);
+		for (auto f : slab_faces[s])
+		{
+			auto const& range = face_ranges[f];
+			auto t = std::array<Vector3r const*, 3>{
+				&mesh.vertex(mesh.faceVertex(f, 0)),
+				&mesh.vertex(mesh.faceVertex(f, 1)),
+				&mesh.vertex(mesh.faceVertex(f, 2))
+			};
+
+			for (auto k = std::max(range[0][2], k_begin); k < std::min(range[1][2] + 1, k_end); ++k)
+			{
+				for (auto j = range[0][1]; j <= range[1][1]; ++j)
+				{
+					// At most one lattice coordinate of a node is not divisible by 3.
+					auto n_off = (j % 3 != 0 ? 1 : 0) + (k % 3 != 0 ? 1 : 0);
+					if (n_off > 1)
+						continue;
+					auto i = range[0][0];
+					auto di = 1;
+					if (n_off == 1)
+					{
+						i = 3 * ((i + 2) / 3);
+						di = 3;
+					}
+
+					for (; i <= range[1][0]; i += di)
+					{
+						auto ijk = MultiIndex{i, j, k};
+						auto d2 = point_triangle_sqdistance(latticeToNodePosition(ijk), t);
+						if (d2 > band_width2)
+							continue;
+
+						auto l = latticeToNodeIndex(ijk);
+						if (d2 < coeffs[l])
+						{
+							coeffs[l] = d2;
+							nearest_face[l] = f;
+						}
+					}
+				}
+			}
+		}
+	}
+
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(n_nodes); ++l)
+	{
+		if (nearest_face[l] >= 0)
+			coeffs[l] = md.signedFaceDistance(indexToNodePosition(l), nearest_face[l]);
+	}
+
+	finalizeDenseField();
+
+	if (verbose)
+	{
+		std::cout << "\rConstruction took " << std::setw(15) << static_cast<real>(duration_cast<milliseconds>(high_resolution_clock::now() - t0_construction).count()) / 1000.0 << "s" << std::endl;
+	}
+
+	return static_cast<int>(m_n_fields - 1);
+}
+
+bool
+CubicLagrangeDiscreteGrid::streamFunction(std::string const& filename, ContinuousFunction const& func,
+	std::size_t slab_budget, Predicate const& pred, bool verbose) const
+{
+	using namespace std::chrono;
+
+	auto t0_construction = high_resolution_clock::now();
+
+	auto out = std::ofstream(filename, std::ios::binary);
+	if (!out.good())
+	{
+		std::cerr << "ERROR: Discrete grid can not be streamed. Output file can not be opened!" << std::endl;
+		return false;
+	}
+
+	auto& n = m_resolution;
+
+	auto nv = static_cast<int64_t>(n[0] + 1) * (n[1] + 1) * (n[2] + 1);
+	auto ne_x = static_cast<int64_t>(n[0] + 0) * (n[1] + 1) * (n[2] + 1);
+	auto ne_y = static_cast<int64_t>(n[0] + 1) * (n[1] + 0) * (n[2] + 1);
+	auto ne_z = static_cast<int64_t>(n[0] + 1) * (n[1] + 1) * (n[2] + 0);
+	auto ne = ne_x + ne_y + ne_z;
+
+	auto n_nodes = nv + 2 * ne;
+
+	// A truncated output file is removed on failure, such that it is not mistaken for a grid.
+	auto discard_output = [&]()
+	{
+		out.close();
+		std::remove(filename.c_str());
+	};
+
+	serialize::write(*out.rdbuf(), m_domain);
+	serialize::write(*out.rdbuf(), m_resolution);
+	serialize::write(*out.rdbuf(), m_cell_size);
+	serialize::write(*out.rdbuf(), m_inv_cell_size);
+	serialize::write(*out.rdbuf(), m_n_cells);
+	serialize::write(*out.rdbuf(), std::size_t{1});
+
+	auto write_array = [](std::ostream& os, void const* data, std::size_t bytes)
+	{
+		os.rdbuf()->sputn(reinterpret_cast<char const*>(data), bytes);
+	};
+
+	auto print_progress = [&](real percentage)
+	{
+		if (verbose)
+		{
+			std::cout << "\r" << "Construction " << std::setw(20) << percentage << "%" << std::flush;
+		}
+	};
+
+	if (!pred)
+	{
+		if (n_nodes > std::numeric_limits<int>::max())
+		{
+			std::cerr << "ERROR: The number of nodes exceeds the index range. The field has to be reduced while streaming." << std::endl;
+			discard_output();
+			return false;
+		}
+
+		auto values = std::vector<real>(std::min(std::max<std::size_t>(1u, slab_budget / sizeof(real)),
+			static_cast<std::size_t>(n_nodes)));
+		serialize::write(*out.rdbuf(), std::size_t{1});
+		serialize::write(*out.rdbuf(), static_cast<std::size_t>(n_nodes));
+		for (auto l0 = int64_t{0}; l0 < n_nodes; l0 += values.size())
+		{
+			auto n_chunk = static_cast<int>(std::min(static_cast<int64_t>(values.size()), n_nodes - l0));
+#pragma omp parallel for schedule(static)
+			for (int l = 0; l < n_chunk; ++l)
+				values[l] = func(indexToNodePosition(static_cast<int>(l0) + l));
+			write_array(out, values.data(), n_chunk * sizeof(real));
+			print_progress(100.0 * static_cast<real>(l0 + n_chunk) / static_cast<real>(n_nodes));
+		}
+		values = std::vector<real>{};
+
+		auto cells = std::vector<std::array<int, 32>>(std::min(std::max<std::size_t>(1u,
+			slab_budget / sizeof(std::array<int, 32>)), m_n_cells));
+		serialize::write(*out.rdbuf(), std::size_t{1});
+		serialize::write(*out.rdbuf(), m_n_cells);
+		for (auto l0 = std::size_t{0}; l0 < m_n_cells; l0 += cells.size())
+		{
+			auto n_chunk = static_cast<int>(std::min(cells.size(), m_n_cells - l0));
+#pragma omp parallel for schedule(static)
+			for (int l = 0; l < n_chunk; ++l)
+				cells[l] = denseCell(static_cast<int>(l0) + l);
+			write_array(out, cells.data(), n_chunk * sizeof(std::array<int, 32>));
+		}
+		cells = std::vector<std::array<int, 32>>{};
+
+		auto cell_map = std::vector<int>(std::min(std::max<std::size_t>(1u, slab_budget / sizeof(int)), m_n_cells));
+		serialize::write(*out.rdbuf(), std::size_t{1});
+		serialize::write(*out.rdbuf(), m_n_cells);
+		for (auto l0 = std::size_t{0}; l0 < m_n_cells; l0 += cell_map.size())
+		{
+			auto n_chunk = std::min(cell_map.size(), m_n_cells - l0);
+			std::iota(cell_map.begin(), cell_map.begin() + n_chunk, static_cast<int>(l0));
+			write_array(out, cell_map.data(), n_chunk * sizeof(int));
+		}
+	}
+	else
+	{
+		// Nodes are organized in layers. Layer k holds the vertex and x- and y-edge
+		// nodes in plane k as well as the z-edge nodes between the planes k and k + 1.
+		auto n_vertex_slots = (n[0] + 1) * (n[1] + 1);
+		auto n_x_slots = 2 * n[0] * (n[1] + 1);
+		auto n_y_slots = 2 * (n[0] + 1) * n[1];
+		auto n_plane_slots = n_vertex_slots + n_x_slots + n_y_slots;
+		auto n_layer_slots = n_plane_slots + 2 * (n[0] + 1) * (n[1] + 1);
+
+		auto slot_to_lattice = [&](int slot, int k) -> MultiIndex
+		{
+			if (slot < n_vertex_slots)
+				return {3 * (slot % (n[0] + 1)), 3 * (slot / (n[0] + 1)), 3 * k};
+			if (slot < n_vertex_slots + n_x_slots)
+			{
+				slot -= n_vertex_slots;
+				auto e = slot / 2;
+				return {3 * (e % n[0]) + 1 + slot % 2, 3 * (e / n[0]), 3 * k};
+			}
+			if (slot < n_plane_slots)
+			{
+				slot -= n_vertex_slots + n_x_slots;
+				auto e = slot / 2;
+				return {3 * (e % (n[0] + 1)), 3 * (e / (n[0] + 1)) + 1 + slot % 2, 3 * k};
+			}
+			slot -= n_plane_slots;
+			auto e = slot / 2;
+			return {3 * (e % (n[0] + 1)), 3 * (e / (n[0] + 1)), 3 * k + 1 + slot % 2};
+		};
+
+		auto lattice_to_slot = [&](MultiIndex const& ijk) -> int
+		{
+			auto i = ijk[0] / 3;
+			auto j = ijk[1] / 3;
+			if (ijk[2] % 3 != 0)
+				return n_plane_slots + 2 * ((n[0] + 1) * j + i) + ijk[2] % 3 - 1;
+			if (ijk[0] % 3 != 0)
+				return n_vertex_slots + 2 * (n[0] * j + i) + ijk[0] % 3 - 1;
+			if (ijk[1] % 3 != 0)
+				return n_vertex_slots + n_x_slots + 2 * ((n[0] + 1) * j + i) + ijk[1] % 3 - 1;
+			return (n[0] + 1) * j + i;
+		};
+
+		auto n_layer_cells = n[0] * n[1];
+		auto layer_bytes = static_cast<std::size_t>(n_layer_slots) * (2 * sizeof(real) + sizeof(char) + sizeof(int))
+			+ static_cast<std::size_t>(n_layer_cells) * (sizeof(char) + sizeof(int) + sizeof(std::array<int, 32>));
+		auto n_slab_layers = static_cast<int>(std::min(std::max<std::size_t>(2u, slab_budget / layer_bytes) - 1u,
+			static_cast<std::size_t>(n[2])));
+
+		struct Layer
+		{
+			std::vector<real> values;
+			std::vector<char> keep;
+			std::vector<int> index;
+		};
+		auto layers = std::vector<Layer>(n_slab_layers + 1);
+		for (auto& layer : layers)
+		{
+			layer.values.resize(n_layer_slots);
+			layer.keep.resize(n_layer_slots);
+			layer.index.resize(n_layer_slots);
+		}
+
+		auto cells_filename = filename + ".cells.tmp";
+		auto cell_map_filename = filename + ".map.tmp";
+		auto cells_out = std::ofstream(cells_filename, std::ios::binary);
+		auto cell_map_out = std::ofstream(cell_map_filename, std::ios::binary);
+		auto discard_temporaries = [&]()
+		{
+			if (cells_out.is_open())
+			{
+				cells_out.close();
+				std::remove(cells_filename.c_str());
+			}
+			if (cell_map_out.is_open())
+			{
+				cell_map_out.close();
+				std::remove(cell_map_filename.c_str());
+			}
+			discard_output();
+		};
+		if (!cells_out.good() || !cell_map_out.good())
+		{
+			std::cerr << "ERROR: Discrete grid can not be streamed. Temporary files can not be opened!" << std::endl;
+			discard_temporaries();
+			return false;
+		}
+
+		serialize::write(*out.rdbuf(), std::size_t{1});
+		auto n_nodes_pos = out.tellp();
+		serialize::write(*out.rdbuf(), std::size_t{0});
+
+		auto n_reduced_nodes = 0;
+		auto n_reduced_cells = 0;
+		auto keep_cell = std::vector<char>();
+		auto slab_cell_map = std::vector<int>();
+		auto slab_cells = std::vector<std::array<int, 32>>();
+		auto slab_values = std::vector<real>();
+		for (auto k0 = 0; k0 < n[2]; k0 += n_slab_layers)
+		{
+			auto k1 = std::min(k0 + n_slab_layers, n[2]);
+
+			// Evaluate the nodes of the layers k0 to k1. The plane nodes of layer k0
+			// are shared with the previous slab and have already been evaluated, while
+			// only the plane nodes of layer k1 belong to the cells of this slab.
+			for (auto k = k0; k <= k1; ++k)
+			{
+				auto& layer = layers[k - k0];
+				auto slot_begin = k == k0 && k0 > 0 ? n_plane_slots : 0;
+				auto slot_end = k == k1 ? n_plane_slots : n_layer_slots;
+				std::fill(layer.index.begin() + slot_begin, layer.index.end(), -1);
+#pragma omp parallel for schedule(static)
+				for (int slot = slot_begin; slot < slot_end; ++slot)
+				{
+					auto x = latticeToNodePosition(slot_to_lattice(slot, k));
+					auto v = func(x);
+					layer.values[slot] = v;
+					layer.keep[slot] = pred(x, v) && v != std::numeric_limits<real>::max();
+				}
+			}
+
+			auto n_slab_cells = (k1 - k0) * n_layer_cells;
+			keep_cell.resize(n_slab_cells);
+#pragma omp parallel for schedule(static)
+			for (int c = 0; c < n_slab_cells; ++c)
+			{
+				auto ijk = MultiIndex{3 * (c % n[0]), 3 * ((c / n[0]) % n[1]), 3 * (c / n_layer_cells)};
+				auto keep = false;
+				for (auto j = 0; j < 32 && !keep; ++j)
+				{
+					auto node = (ijk + MultiIndex{lattice_offset(j, 0), lattice_offset(j, 1), lattice_offset(j, 2)}).eval();
+					keep = layers[node[2] / 3].keep[lattice_to_slot(node)] != 0;
+				}
+				keep_cell[c] = keep;
+			}
+
+			// Number the nodes of the remaining cells in the order of their first occurrence.
+			slab_cell_map.resize(n_slab_cells);
+			slab_cells.clear();
+			slab_values.clear();
+			for (auto c = 0; c < n_slab_cells; ++c)
+			{
+				if (!keep_cell[c])
+				{
+					slab_cell_map[c] = std::numeric_limits<int>::max();
+					continue;
+				}
+
+				auto ijk = MultiIndex{3 * (c % n[0]), 3 * ((c / n[0]) % n[1]), 3 * (c / n_layer_cells)};
+				auto cell = std::array<int, 32>{};
+				for (auto j = 0; j < 32; ++j)
+				{
+					auto node = (ijk + MultiIndex{lattice_offset(j, 0), lattice_offset(j, 1), lattice_offset(j, 2)}).eval();
+					auto& layer = layers[node[2] / 3];
+					auto slot = lattice_to_slot(node);
+					if (layer.index[slot] < 0)
+					{
+						if (n_reduced_nodes == std::numeric_limits<int>::max())
+						{
+							std::cerr << "ERROR: The number of remaining nodes exceeds the index range." << std::endl;
+							discard_temporaries();
+							return false;
+						}
+						layer.index[slot] = n_reduced_nodes++;
+						slab_values.push_back(layer.values[slot]);
+					}
+					cell[j] = layer.index[slot];
+				}
+				slab_cells.push_back(cell);
+				slab_cell_map[c] = n_reduced_cells++;
+			}
+
+			write_array(out, slab_values.data(), slab_values.size() * sizeof(real));
+			write_array(cells_out, slab_cells.data(), slab_cells.size() * sizeof(std::array<int, 32>));
+			write_array(cell_map_out, slab_cell_map.data(), slab_cell_map.size() * sizeof(int));
+
+			std::swap(layers[0], layers[k1 - k0]);
+			print_progress(100.0 * static_cast<real>(k1) / static_cast<real>(n[2]));
+		}
+		layers.clear();
+		cells_out.close();
+		cell_map_out.close();
+
+		auto copy_file = [&](std::string const& source)
+		{
+			auto in = std::ifstream(source, std::ios::binary);
+			auto buffer = std::vector<char>(std::max<std::size_t>(1u, slab_budget));
+			while (in)
+			{
+				in.read(buffer.data(), buffer.size());
+				write_array(out, buffer.data(), static_cast<std::size_t>(in.gcount()));
+			}
+			in.close();
+			std::remove(source.c_str());
+		};
+
+		serialize::write(*out.rdbuf(), std::size_t{1});
+		serialize::write(*out.rdbuf(), static_cast<std::size_t>(n_reduced_cells));
+		copy_file(cells_filename);
+
+		serialize::write(*out.rdbuf(), std::size_t{1});
+		serialize::write(*out.rdbuf(), m_n_cells);
+		copy_file(cell_map_filename);
+
+		out.seekp(n_nodes_pos);
+		serialize::write(*out.rdbuf(), static_cast<std::size_t>(n_reduced_nodes));
+		out.seekp(0, std::ios::end);
+	}
+
+	out.close();
+	if (!out)
 	{
-		auto xi = indexToNodePosition(l);
-		keep[l] = pred(xi, coeffs[l]) && coeffs[l] != std::numeric_limits<real>::max();
+		std::cerr << "ERROR: Discrete grid can not be streamed. Writing the output file failed!" << std::endl;
+		std::remove(filename.c_str());
+		return false;
+	}
+
+	if (verbose)
+	{
+		std::cout << "\rConstruction took " << std::setw(15) << static_cast<real>(duration_cast<milliseconds>(high_resolution_clock::now() - t0_construction).count()) / 1000.0 << "s" << std::endl;
+	}
+
+	return true;
+}
+
+CubicLagrangeDiscreteGrid
+CubicLagrangeDiscreteGrid::shard(MultiIndex const& cell_begin, MultiIndex const& cell_end) const
+{
+	if ((cell_begin.array() < 0).any() || (cell_end.array() > m_resolution.array()).any() ||
+		(cell_begin.array() >= cell_end.array()).any())
+	{
+		std::cerr << "ERROR: Shard can not be created. The cell range is empty or exceeds the grid!" << std::endl;
+		return CubicLagrangeDiscreteGrid{};
 	}
 
-	auto &cell_map = m_cell_map[field_id];
-	cell_map.resize(m_n_cells);
-	std::iota(cell_map.begin(), cell_map.end(), 0u);
+	auto domain = AlignedBox3r{
+		m_domain.min() + m_cell_size.cwiseProduct(cell_begin.cast<real>()),
+		m_domain.min() + m_cell_size.cwiseProduct(cell_end.cast<real>())};
+	return CubicLagrangeDiscreteGrid(domain, (cell_end - cell_begin).eval());
+}
+
+bool
+CubicLagrangeDiscreteGrid::merge(std::vector<std::string> const& shard_filenames, bool verbose)
+{
+	using namespace std::chrono;
+
+	auto t0_merge = high_resolution_clock::now();
+
+	if (shard_filenames.empty())
+	{
+		std::cerr << "ERROR: Discrete grids can not be merged. No shards given!" << std::endl;
+		return false;
+	}
 
-	auto cells_ = cells;
-	cells.clear();
-	for (auto i = 0u; i < cells_.size(); ++i)
+	struct ShardHeader
 	{
-		auto keep_cell = false;
-		auto vals = std::vector<real>{};
-		for (auto v : cells_[i])
+		AlignedBox3r domain;
+		Eigen::Vector3i resolution;
+		Vector3r cell_size;
+		std::size_t n_fields;
+	};
+	auto headers = std::vector<ShardHeader>(shard_filenames.size());
+	for (auto s = 0u; s < shard_filenames.size(); ++s)
+	{
+		auto& header = headers[s];
+		if (!read_grid_header(shard_filenames[s], header.domain, header.resolution, header.cell_size, header.n_fields))
 		{
-			keep_cell |= keep[v];
-			vals.push_back(coeffs[v]);
+			std::cerr << "ERROR: Discrete grids can not be merged. Shard " << shard_filenames[s] << " can not be read!" << std::endl;
+			return false;
 		}
-		if (keep_cell)
+	}
+
+	// The shards are placed by their offsets on the cell lattice of the merged grid.
+	auto cell_size = headers.front().cell_size;
+	auto n_fields = headers.front().n_fields;
+	auto domain = AlignedBox3r{};
+	domain.setEmpty();
+	for (auto const& header : headers)
+	{
+		if (header.n_fields != n_fields || !header.cell_size.isApprox(cell_size, 1.0e-4))
 		{
-			cells.push_back(cells_[i]);
-			cell_map[i] = static_cast<int>(cells.size() - 1);
+			std::cerr << "ERROR: Discrete grids can not be merged. The shards differ in cell size or number of fields!" << std::endl;
+			return false;
 		}
-		else
-			cell_map[i] = std::numeric_limits<int>::max();
+		domain.extend(header.domain);
 	}
 
-	auto& n = m_resolution;
+	auto offsets = std::vector<MultiIndex>(headers.size());
+	auto resolution = MultiIndex::Zero().eval();
+	for (auto s = 0u; s < headers.size(); ++s)
+	{
+		auto offset = (headers[s].domain.min() - domain.min()).cwiseQuotient(cell_size).eval();
+		offsets[s] = offset.array().round().cast<int>();
+		if ((offset - offsets[s].cast<real>()).cwiseAbs().maxCoeff() > 1.0e-2)
+		{
+			std::cerr << "ERROR: Discrete grids can not be merged. The shards are not aligned to a common cell lattice!" << std::endl;
+			return false;
+		}
+		resolution = resolution.cwiseMax(offsets[s] + headers[s].resolution);
+	}
+	domain.max() = domain.min() + cell_size.cwiseProduct(resolution.cast<real>());
+
+	auto& n = resolution;
+	auto n_nodes = static_cast<int64_t>(n[0] + 1) * (n[1] + 1) * (n[2] + 1)
+		+ 2 * (static_cast<int64_t>(n[0] + 0) * (n[1] + 1) * (n[2] + 1)
+		+ static_cast<int64_t>(n[0] + 1) * (n[1] + 0) * (n[2] + 1)
+		+ static_cast<int64_t>(n[0] + 1) * (n[1] + 1) * (n[2] + 0));
+	if (n_nodes > std::numeric_limits<int>::max())
+	{
+		std::cerr << "ERROR: Discrete grids can not be merged. The number of nodes exceeds the index range!" << std::endl;
+		return false;
+	}
 
-	auto nv = (n[0] + 1) * (n[1] + 1) * (n[2] + 1);
-	auto ne_x = (n[0] + 0) * (n[1] + 1) * (n[2] + 1);
-	auto ne_y = (n[0] + 1) * (n[1] + 0) * (n[2] + 1);
-	auto ne_z = (n[0] + 1) * (n[1] + 1) * (n[2] + 0);
-	auto ne = ne_x + ne_y + ne_z;
+	*this = CubicLagrangeDiscreteGrid(domain, resolution);
 
-	// Reduce vertices.
-	auto xi = Vector3r{};
-	auto z_values = std::vector<uint64_t>(coeffs.size());
-	for (auto l = 0u; l < coeffs.size(); ++l)
+	// Values and covered cells are first gathered on the full set of nodes and cells.
+	auto values = std::vector<std::vector<real>>(n_fields,
+		std::vector<real>(static_cast<std::size_t>(n_nodes), std::numeric_limits<real>::max()));
+	auto covered = std::vector<std::vector<int>>(n_fields,
+		std::vector<int>(m_n_cells, std::numeric_limits<int>::max()));
+
+	for (auto s = 0u; s < shard_filenames.size(); ++s)
+	{
+		auto shard = CubicLagrangeDiscreteGrid(shard_filenames[s]);
+		auto& ns = shard.m_resolution;
+		for (auto f = 0u; f < n_fields; ++f)
+		{
+			auto const& shard_nodes = shard.m_nodes[f];
+			auto const& shard_cell_map = shard.m_cell_map[f];
+
+			// Cell layers of equal parity do not share any nodes and are processed concurrently.
+			for (auto parity = 0; parity < 2; ++parity)
+			{
+#pragma omp parallel for schedule(dynamic, 1)
+				for (int k = parity; k < ns[2]; k += 2)
+				{
+					for (auto j = 0; j < ns[1]; ++j)
+					{
+						for (auto i = 0; i < ns[0]; ++i)
+						{
+							auto c = shard_cell_map[shard.multiToSingleIndex({i, j, k})];
+							if (c == std::numeric_limits<int>::max())
+								continue;
+
+							auto ijk = (offsets[s] + MultiIndex{i, j, k}).eval();
+							covered[f][multiToSingleIndex(ijk)] = 0;
+
+							auto cell = shard.fieldCell(f, c);
+							for (auto l = 0; l < 32; ++l)
+							{
+								auto node = (3 * ijk + MultiIndex{lattice_offset(l, 0), lattice_offset(l, 1), lattice_offset(l, 2)}).eval();
+								values[f][latticeToNodeIndex(node)] = shard_nodes[cell[l]];
+							}
+						}
+					}
+				}
+			}
+		}
+
+		if (verbose)
+		{
+			std::cout << "\r" << "Merge " << std::setw(20) << 100.0 * static_cast<real>(s + 1) / static_cast<real>(shard_filenames.size()) << "%" << std::flush;
+		}
+	}
+
+	for (auto f = 0u; f < n_fields; ++f)
+	{
+		m_nodes.push_back(std::move(values[f]));
+
+		auto n_covered = std::count(covered[f].begin(), covered[f].end(), 0);
+		if (static_cast<std::size_t>(n_covered) == m_n_cells)
+		{
+			finalizeDenseField();
+			continue;
+		}
+
+		m_cells.push_back({});
+		m_cell_map.push_back({});
+		auto keep_cell = std::vector<char>(m_n_cells);
+		std::transform(covered[f].begin(), covered[f].end(), keep_cell.begin(),
+			[](int c) { return c != std::numeric_limits<int>::max(); });
+		covered[f] = std::vector<int>{};
+		removeCells(static_cast<int>(m_n_fields++), keep_cell, {});
+	}
+
+	if (verbose)
 	{
-		auto xi = indexToNodePosition(l);
-		z_values[l] = zValue(xi, 4.0 * m_inv_cell_size.minCoeff());
+		std::cout << "\rMerge took " << std::setw(15) << static_cast<real>(duration_cast<milliseconds>(high_resolution_clock::now() - t0_merge).count()) / 1000.0 << "s" << std::endl;
 	}
 
-	std::fill(keep.begin(), keep.end(), false);
+	return true;
+}
+
+CubicLagrangeDiscreteGrid
+CubicLagrangeDiscreteGrid::resample(AlignedBox3r const& target_domain,
+	Eigen::Vector3i const& target_resolution, bool verbose) const
+{
+	auto field_ids = std::vector<int>(m_n_fields);
+	std::iota(field_ids.begin(), field_ids.end(), 0);
+	return resample(target_domain, target_resolution, field_ids, verbose);
+}
+
+CubicLagrangeDiscreteGrid
+CubicLagrangeDiscreteGrid::resample(AlignedBox3r const& target_domain,
+	Eigen::Vector3i const& target_resolution, std::vector<int> const& field_ids, bool verbose) const
+{
+	using namespace std::chrono;
+
+	auto t0_construction = high_resolution_clock::now();
+
+	auto result = CubicLagrangeDiscreteGrid(target_domain, target_resolution);
+	for (auto f : field_ids)
+		requireField(f);
+
+	auto& n = target_resolution;
+	auto n_nodes = static_cast<int64_t>(n[0] + 1) * (n[1] + 1) * (n[2] + 1)
+		+ 2 * (static_cast<int64_t>(n[0] + 0) * (n[1] + 1) * (n[2] + 1)
+		+ static_cast<int64_t>(n[0] + 1) * (n[1] + 0) * (n[2] + 1)
+		+ static_cast<int64_t>(n[0] + 1) * (n[1] + 1) * (n[2] + 0));
+	if (n_nodes > std::numeric_limits<int>::max())
+	{
+		std::cerr << "ERROR: Discrete grid can not be resampled. The number of nodes exceeds the index range!" << std::endl;
+		return result;
+	}
 
-	auto vertex_to_cell = std::vector<std::set<std::pair<int, int>>>(coeffs.size());
-	for (auto c = 0u; c < cells.size(); ++c)
+	// Determine the source cell of each target node.
+	auto source_cell = std::vector<int>(static_cast<std::size_t>(n_nodes));
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(n_nodes); ++l)
 	{
-		auto const &cell = cells[c];
+		// Nodes on the boundary of the domain are accepted up to round-off.
+		auto p = (result.indexToNodePosition(l) - m_domain.min()).cwiseProduct(m_inv_cell_size).eval();
+		if ((p.array() < -1.0e-6).any() || (p.array() > m_resolution.cast<real>().array() + 1.0e-6).any())
+		{
+			source_cell[l] = -1;
+			continue;
+		}
 
-		for (auto j = 0u; j < cell.size(); ++j)
+		auto mi = p.cwiseMax(Vector3r::Zero()).cast<int>().cwiseMin(m_resolution - MultiIndex::Ones()).eval();
+		source_cell[l] = multiToSingleIndex(mi);
+	}
+
+	// Group the target nodes by source cell using a counting sort.
+	auto bucket_begin = std::vector<int>(m_n_cells + 1, 0);
+	for (auto c : source_cell)
+	{
+		if (c >= 0)
+			++bucket_begin[c + 1];
+	}
+	std::partial_sum(bucket_begin.begin(), bucket_begin.end(), bucket_begin.begin());
+	auto bucket_nodes = std::vector<int>(bucket_begin.back());
+	{
+		auto cursor = std::vector<int>(bucket_begin.begin(), bucket_begin.end() - 1);
+		for (auto l = 0; l < static_cast<int>(n_nodes); ++l)
 		{
-			auto v = cell[j];
-			keep[v] = true;
-			vertex_to_cell[v].insert({c, j});
+			if (source_cell[l] >= 0)
+				bucket_nodes[cursor[source_cell[l]]++] = l;
 		}
 	}
-	auto last_vertex = static_cast<int>(coeffs.size() - 1);
-	for (auto i = static_cast<int>(coeffs.size() - 1); i >= 0; --i)
+	source_cell = std::vector<int>{};
+
+	for (auto r = 0u; r < field_ids.size(); ++r)
+	{
+		result.m_nodes.push_back(std::vector<real>(static_cast<std::size_t>(n_nodes), std::numeric_limits<real>::max()));
+	}
+
+	// Evaluates field f at a node on the boundary of a cell that does not belong to
+	// the field using the other cells touching the node.
+	auto evaluate_in_neighbors = [&](int f, Vector3r const& x) -> real
+	{
+		auto p = (x - m_domain.min()).cwiseProduct(m_inv_cell_size).eval();
+		auto lower = (p.array() - 1.0e-6).floor().cast<int>().max(0).matrix().eval();
+		auto upper = (p.array() + 1.0e-6).floor().cast<int>().min(m_resolution.array() - 1).matrix().eval();
+		for (auto k = lower[2]; k <= upper[2]; ++k)
+			for (auto j = lower[1]; j <= upper[1]; ++j)
+				for (auto i = lower[0]; i <= upper[0]; ++i)
+				{
+					auto c = multiToSingleIndex({i, j, k});
+					auto c_ = m_cell_map[f][c];
+					if (c_ == std::numeric_limits<int>::max())
+						continue;
+
+					auto sd = subdomain(c);
+					auto denom = (sd.max() - sd.min()).eval();
+					auto c0 = Vector3r::Constant(2.0).cwiseQuotient(denom).eval();
+					auto c1 = (sd.max() + sd.min()).cwiseQuotient(denom).eval();
+					auto N = shape_function_((c0.cwiseProduct(x) - c1).eval(), nullptr);
+					auto phi = interpolate(f, x, fieldCell(f, c_), c0, N);
+					if (phi != std::numeric_limits<real>::max())
+						return phi;
+				}
+		return std::numeric_limits<real>::max();
+	};
+
+#pragma omp parallel default(shared)
 	{
-		if (!keep[i])
+		auto coefficients = std::vector<Matrix<real, 32, 1>>(field_ids.size());
+		auto valid = std::vector<char>(field_ids.size());
+
+#pragma omp for schedule(dynamic, 64)
+		for (int c = 0; c < static_cast<int>(m_n_cells); ++c)
 		{
-			std::swap(coeffs[i], coeffs[last_vertex]);
-			std::swap(z_values[i], z_values[last_vertex]);
-			std::swap(vertex_to_cell[i], vertex_to_cell[last_vertex]);
-			for (auto const &kvp : vertex_to_cell[i])
+			if (bucket_begin[c] == bucket_begin[c + 1])
+				continue;
+
+			// Gather the coefficients of the cell once for all of its target nodes.
+			for (auto r = 0u; r < field_ids.size(); ++r)
+			{
+				auto f = field_ids[r];
+				auto c_ = m_cell_map[f][c];
+				valid[r] = c_ != std::numeric_limits<int>::max();
+				auto cell = valid[r] ? fieldCell(f, c_) : std::array<int, 32>{};
+				for (auto j = 0; j < 32 && valid[r]; ++j)
+				{
+					coefficients[r][j] = m_nodes[f][cell[j]];
+					valid[r] = coefficients[r][j] != std::numeric_limits<real>::max();
+				}
+			}
+
+			auto sd = subdomain(c);
+			auto denom = (sd.max() - sd.min()).eval();
+			auto c0 = Vector3r::Constant(2.0).cwiseQuotient(denom).eval();
+			auto c1 = (sd.max() + sd.min()).cwiseQuotient(denom).eval();
+
+			for (auto b = bucket_begin[c]; b < bucket_begin[c + 1]; ++b)
 			{
-				cells[kvp.first][kvp.second] = i;
+				auto l = bucket_nodes[b];
+				auto xi = (c0.cwiseProduct(result.indexToNodePosition(l)) - c1).eval();
+				auto N = shape_function_(xi, nullptr);
+				for (auto r = 0u; r < field_ids.size(); ++r)
+				{
+					if (valid[r])
+						result.m_nodes[r][l] = coefficients[r].dot(N);
+					else
+						result.m_nodes[r][l] = evaluate_in_neighbors(field_ids[r], result.indexToNodePosition(l));
+				}
 			}
-			for (auto const &kvp : vertex_to_cell[last_vertex])
+		}
+	}
+
+	for (auto r = 0u; r < field_ids.size(); ++r)
+	{
+		result.finalizeDenseField();
+	}
+	for (auto r = 0u; r < field_ids.size(); ++r)
+	{
+		if (nFieldCells(field_ids[r]) < m_n_cells)
+			result.reduceField(r, [](Vector3r const&, real) { return true; });
+	}
+
+	if (verbose)
+	{
+		std::cout << "Resampling took " << std::setw(15) << static_cast<real>(duration_cast<milliseconds>(high_resolution_clock::now() - t0_construction).count()) / 1000.0 << "s" << std::endl;
+	}
+
+	return result;
+}
+
+std::vector<real>
+CubicLagrangeDiscreteGrid::denseNodes(int field_id) const
+{
+	requireField(field_id);
+	auto& n = m_resolution;
+	auto n_nodes = (n[0] + 1) * (n[1] + 1) * (n[2] + 1)
+		+ 2 * ((n[0] + 0) * (n[1] + 1) * (n[2] + 1)
+		+ (n[0] + 1) * (n[1] + 0) * (n[2] + 1)
+		+ (n[0] + 1) * (n[1] + 1) * (n[2] + 0));
+
+	auto const& coeffs = m_nodes[field_id];
+	auto const& cells = m_cells[field_id];
+	auto const& cell_map = m_cell_map[field_id];
+	auto values = std::vector<real>(n_nodes, std::numeric_limits<real>::max());
+
+	// Cell layers of equal parity do not share any nodes and are processed concurrently.
+	auto n_layer_cells = n[0] * n[1];
+	for (auto parity = 0; parity < 2; ++parity)
+	{
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int k = parity; k < n[2]; k += 2)
+		{
+			for (auto l = k * n_layer_cells; l < (k + 1) * n_layer_cells; ++l)
 			{
-				cells[kvp.first][kvp.second] = last_vertex;
+				auto c = cell_map[l];
+				if (c == std::numeric_limits<int>::max())
+					continue;
+
+				auto dense_cell = denseCell(l);
+				auto const& cell = cells.empty() ? dense_cell : cells[c];
+				for (auto j = 0; j < 32; ++j)
+					values[dense_cell[j]] = coeffs[cell[j]];
 			}
+		}
+	}
+	return values;
+}
+
+CubicLagrangeDiscreteGrid
+CubicLagrangeDiscreteGrid::combine(CubicLagrangeDiscreteGrid const& a, int field_a,
+	CubicLagrangeDiscreteGrid const& b, int field_b, CombineFunction const& op, bool verbose)
+{
+	using namespace std::chrono;
+
+	auto t0_construction = high_resolution_clock::now();
+
+	auto domain = a.m_domain;
+	auto resolution = a.m_resolution;
+	auto values_a = std::vector<real>{};
+	auto values_b = std::vector<real>{};
+	if (a.m_resolution == b.m_resolution && a.m_domain.isApprox(b.m_domain))
+	{
+		values_a = a.denseNodes(field_a);
+		values_b = b.denseNodes(field_b);
+	}
+	else
+	{
+		domain = a.m_domain.merged(b.m_domain);
+		auto cell_size = a.m_cell_size.cwiseMin(b.m_cell_size);
+		resolution = (domain.diagonal().cwiseQuotient(cell_size).array() - 1.0e-4).ceil().cast<int>().max(1);
+		values_a = a.resample(domain, resolution, std::vector<int>{field_a}, false).denseNodes(0);
+		values_b = b.resample(domain, resolution, std::vector<int>{field_b}, false).denseNodes(0);
+	}
+
+	auto result = CubicLagrangeDiscreteGrid(domain, resolution);
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(values_a.size()); ++l)
+	{
+		if (values_a[l] != std::numeric_limits<real>::max() || values_b[l] != std::numeric_limits<real>::max())
+			values_a[l] = op(values_a[l], values_b[l]);
+	}
+	values_b = std::vector<real>{};
+
+	result.m_nodes.push_back(std::move(values_a));
+	result.finalizeDenseField();
+	if (a.nFieldCells(field_a) < a.m_n_cells || b.nFieldCells(field_b) < b.m_n_cells)
+		result.reduceField(0, [](Vector3r const&, real) { return true; });
+
+	if (verbose)
+	{
+		std::cout << "Combination took " << std::setw(15) << static_cast<real>(duration_cast<milliseconds>(high_resolution_clock::now() - t0_construction).count()) / 1000.0 << "s" << std::endl;
+	}
+
+	return result;
+}
+
+CubicLagrangeDiscreteGrid
+CubicLagrangeDiscreteGrid::csgUnion(CubicLagrangeDiscreteGrid const& a,
+	CubicLagrangeDiscreteGrid const& b, int field_a, int field_b)
+{
+	return combine(a, field_a, b, field_b, [](real va, real vb) { return std::min(va, vb); });
+}
+
+CubicLagrangeDiscreteGrid
+CubicLagrangeDiscreteGrid::csgIntersection(CubicLagrangeDiscreteGrid const& a,
+	CubicLagrangeDiscreteGrid const& b, int field_a, int field_b)
+{
+	return combine(a, field_a, b, field_b, [](real va, real vb) { return std::max(va, vb); });
+}
+
+CubicLagrangeDiscreteGrid
+CubicLagrangeDiscreteGrid::csgDifference(CubicLagrangeDiscreteGrid const& a,
+	CubicLagrangeDiscreteGrid const& b, int field_a, int field_b)
+{
+	return combine(a, field_a, b, field_b, [](real va, real vb) { return std::max(va, -vb); });
+}
+
+CubicLagrangeDiscreteGrid
+CubicLagrangeDiscreteGrid::csgSmoothUnion(CubicLagrangeDiscreteGrid const& a,
+	CubicLagrangeDiscreteGrid const& b, real k, int field_a, int field_b)
+{
+	return combine(a, field_a, b, field_b, [k](real va, real vb) -> real
+	{
+		if (va == std::numeric_limits<real>::max() || vb == std::numeric_limits<real>::max() || k <= 0.0)
+			return std::min(va, vb);
+
+		// Polynomial smooth minimum.
+		auto h = std::min(std::max(static_cast<real>(0.5 + 0.5 * (vb - va) / k), real(0.0)), real(1.0));
+		return (1.0 - h) * vb + h * va - k * h * (1.0 - h);
+	});
+}
+
+void
+CubicLagrangeDiscreteGrid::offsetField(int field_id, real distance)
+{
+	requireField(field_id);
+	auto& coeffs = m_nodes[field_id];
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(coeffs.size()); ++l)
+	{
+		if (coeffs[l] != std::numeric_limits<real>::max())
+			coeffs[l] -= distance;
+	}
+}
+
+bool
+CubicLagrangeDiscreteGrid::determineShapeFunctions(int field_id, Vector3r const &x,
+	std::array<int, 32> &cell, Vector3r &c0, Eigen::Matrix<real, 32, 1> &N,
+	Eigen::Matrix<real, 32, 3> *dN) const
+{
+	if (!isReady())
+		return false;
+	requireField(field_id);
+	auto field = field_view(m_nodes[field_id], m_cells[field_id], m_cell_map[field_id]);
+	return cubic_lagrange::determineShapeFunctions(*this, field, x, cell, c0, N, dN);
+}
+
+real
+CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const& xi, const std::array<int, 32> &cell, const Vector3r &c0, const Eigen::Matrix<real, 32, 1> &N,
+	Vector3r* gradient, Eigen::Matrix<real, 32, 3> *dN) const
+{
+	if (!isReady())
+		return std::numeric_limits<real>::max();
+	requireField(field_id);
+	auto field = field_view(m_nodes[field_id], m_cells[field_id], m_cell_map[field_id]);
+	return cubic_lagrange::interpolate(field, cell, c0, N, gradient, dN);
+}
+
+real
+CubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const &x,
+									   Vector3r *gradient) const
+{
+	if (!isReady())
+		return std::numeric_limits<real>::max();
+	requireField(field_id);
+	auto field = field_view(m_nodes[field_id], m_cells[field_id], m_cell_map[field_id]);
+	return cubic_lagrange::interpolate(*this, field, x, gradient);
+}
+
+void CubicLagrangeDiscreteGrid::reduceField(int field_id, Predicate pred)
+{
+	requireField(field_id);
+	auto const& coeffs = m_nodes[field_id];
+	auto const& cell_map = m_cell_map[field_id];
+	auto dense_nodes = denseNodeIndices(field_id);
+	auto keep = std::vector<char>(coeffs.size());
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(coeffs.size()); ++l)
+	{
+		auto xi = indexToNodePosition(dense_nodes.empty() ? l : dense_nodes[l]);
+		keep[l] = pred(xi, coeffs[l]) && coeffs[l] != std::numeric_limits<real>::max();
+	}
+
+	auto keep_cell = std::vector<char>(m_n_cells);
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(m_n_cells); ++l)
+	{
+		auto c = cell_map[l];
+		if (c == std::numeric_limits<int>::max())
+			continue;
+		auto cell = fieldCell(field_id, c);
+		keep_cell[l] = std::any_of(cell.begin(), cell.end(), [&](int v) { return keep[v] != 0; });
+	}
+	keep = std::vector<char>{};
+
+	removeCells(field_id, keep_cell, dense_nodes);
+}
+
+std::vector<int> CubicLagrangeDiscreteGrid::denseNodeIndices(int field_id) const
+{
+	if (hasImplicitCells(field_id))
+		return {};
 
-			last_vertex--;
+	// Cell layers of equal parity do not share any nodes and are processed concurrently.
+	auto const& cell_map = m_cell_map[field_id];
+	auto& n = m_resolution;
+	auto n_layer_cells = n[0] * n[1];
+	auto dense_nodes = std::vector<int>(m_nodes[field_id].size());
+	for (auto parity = 0; parity < 2; ++parity)
+	{
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int k = parity; k < n[2]; k += 2)
+		{
+			for (auto l = k * n_layer_cells; l < (k + 1) * n_layer_cells; ++l)
+			{
+				auto c = cell_map[l];
+				if (c == std::numeric_limits<int>::max())
+					continue;
+				auto cell = fieldCell(field_id, c);
+				auto dense_cell = denseCell(l);
+				for (auto v = 0; v < 32; ++v)
+					dense_nodes[cell[v]] = dense_cell[v];
+			}
 		}
 	}
-	coeffs.resize(last_vertex + 1);
-	z_values.resize(coeffs.size());
+	return dense_nodes;
+}
+
+void CubicLagrangeDiscreteGrid::removeCells(int field_id, std::vector<char> const& keep_cell,
+	std::vector<int> const& dense_nodes)
+{
+	auto &coeffs = m_nodes[field_id];
+	auto &cells = m_cells[field_id];
 
-	auto sort_pattern = std::vector<int>(coeffs.size());
-	std::iota(sort_pattern.begin(), sort_pattern.end(), 0u);
-	std::sort(sort_pattern.begin(), sort_pattern.end(),
-			  [&](int i, int j) {
-				  return z_values[i] < z_values[j];
-			  });
+	// Number the remaining cells in their original order.
+	auto old_cells = std::move(cells);
+	auto old_cell_map = std::move(m_cell_map[field_id]);
+	auto old_cell = [&](int l)
+	{
+		return old_cells.empty() ? denseCell(l) : old_cells[old_cell_map[l]];
+	};
+	cells = std::vector<std::array<int, 32>>{};
+	m_cell_map[field_id] = CellMap(m_resolution, keep_cell);
+	auto const& cell_map = m_cell_map[field_id];
+	auto n_cells = std::count_if(keep_cell.begin(), keep_cell.end(), [](char keep) { return keep != 0; });
+
+	// Mark the nodes of the remaining cells. Cell layers of equal parity do not
+	// share any nodes and are processed concurrently.
+	auto& n = m_resolution;
+	auto n_layer_cells = n[0] * n[1];
+	auto keep = std::vector<char>(coeffs.size(), 0);
+	for (auto parity = 0; parity < 2; ++parity)
+	{
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int k = parity; k < n[2]; k += 2)
+		{
+			for (auto l = k * n_layer_cells; l < (k + 1) * n_layer_cells; ++l)
+			{
+				if (!keep_cell[l])
+					continue;
+				for (auto v : old_cell(l))
+					keep[v] = 1;
+			}
+		}
+	}
 
-	for (auto i = 0u; i < sort_pattern.size(); ++i)
+	// Sort the remaining nodes along a z-curve, where ties are broken by the node index.
+	auto node_map = std::vector<int>(coeffs.size());
+	auto n_nodes = parallel_exclusive_scan(keep, node_map);
+	auto sort_pattern = std::vector<std::pair<uint64_t, int>>(n_nodes);
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(coeffs.size()); ++l)
 	{
-		auto j = sort_pattern[i];
-		for (auto const &kvp : vertex_to_cell[j])
+		if (keep[l])
 		{
-			assert(cells[kvp.first][kvp.second] == j);
-			cells[kvp.first][kvp.second] = i;
+			auto xi = indexToNodePosition(dense_nodes.empty() ? l : dense_nodes[l]);
+			sort_pattern[node_map[l]] = {zValue(xi, 4.0 * m_inv_cell_size.minCoeff()), l};
 		}
 	}
+	keep = std::vector<char>{};
+	parallel_sort(sort_pattern);
+
+	auto reduced_coeffs = std::vector<real>(n_nodes);
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < n_nodes; ++i)
+	{
+		auto l = sort_pattern[i].second;
+		reduced_coeffs[i] = coeffs[l];
+		node_map[l] = i;
+	}
+	sort_pattern = std::vector<std::pair<uint64_t, int>>{};
+	coeffs = std::move(reduced_coeffs);
+
+	cells.resize(n_cells);
+#pragma omp parallel for schedule(static)
+	for (int l = 0; l < static_cast<int>(m_n_cells); ++l)
+	{
+		if (!keep_cell[l])
+			continue;
 
-	auto coeffs_ = coeffs;
-	std::transform(sort_pattern.begin(), sort_pattern.end(), coeffs.begin(),
-				   [&coeffs_](int i) { return coeffs_[i]; });
+		auto& cell = cells[cell_map[l]];
+		cell = old_cell(l);
+		for (auto& v : cell)
+			v = node_map[v];
+	}
 }
 
 void CubicLagrangeDiscreteGrid::forEachCell(std::function<void(int, AlignedBox3r const &, int)> const &cb) const
@@ -1193,405 +3230,52 @@ void CubicLagrangeDiscreteGrid::forEachCell(std::function<void(int, AlignedBox3r
 	}
 }
 
-static int edgeTable[256]={
-        0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
-        0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
-        0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
-        0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
-        0x230, 0x339, 0x33 , 0x13a, 0x636, 0x73f, 0x435, 0x53c,
-        0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
-        0x3a0, 0x2a9, 0x1a3, 0xaa , 0x7a6, 0x6af, 0x5a5, 0x4ac,
-        0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
-        0x460, 0x569, 0x663, 0x76a, 0x66 , 0x16f, 0x265, 0x36c,
-        0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
-        0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0xff , 0x3f5, 0x2fc,
-        0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
-        0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x55 , 0x15c,
-        0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
-        0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0xcc ,
-        0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
-        0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
-        0xcc , 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
-        0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
-        0x15c, 0x55 , 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
-        0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
-        0x2fc, 0x3f5, 0xff , 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
-        0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
-        0x36c, 0x265, 0x16f, 0x66 , 0x76a, 0x663, 0x569, 0x460,
-        0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
-        0x4ac, 0x5a5, 0x6af, 0x7a6, 0xaa , 0x1a3, 0x2a9, 0x3a0,
-        0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
-        0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x33 , 0x339, 0x230,
-        0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
-        0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x99 , 0x190,
-        0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
-        0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0   };
-
-static int triTable[256][16] =
-        {{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1},
-         {3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1},
-         {3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1},
-         {3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1},
-         {9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1},
-         {9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
-         {2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1},
-         {8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1},
-         {9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
-         {4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1},
-         {3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1},
-         {1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1},
-         {4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1},
-         {4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1},
-         {9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
-         {5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1},
-         {2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1},
-         {9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
-         {0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
-         {2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1},
-         {10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1},
-         {4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1},
-         {5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1},
-         {5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1},
-         {9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1},
-         {0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1},
-         {1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1},
-         {10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1},
-         {8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1},
-         {2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1},
-         {7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1},
-         {9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1},
-         {2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1},
-         {11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1},
-         {9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1},
-         {5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1},
-         {11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1},
-         {11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
-         {1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1},
-         {9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1},
-         {5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1},
-         {2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
-         {0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
-         {5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1},
-         {6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1},
-         {3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
-         {6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1},
-         {5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1},
-         {1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
-         {10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1},
-         {6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1},
-         {8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1},
-         {7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1},
-         {3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
-         {5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1},
-         {0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1},
-         {9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1},
-         {8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1},
-         {5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1},
-         {0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1},
-         {6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1},
-         {10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1},
-         {10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1},
-         {8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1},
-         {1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1},
-         {3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1},
-         {0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1},
-         {10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1},
-         {3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1},
-         {6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1},
-         {9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1},
-         {8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1},
-         {3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
-         {6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1},
-         {0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1},
-         {10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1},
-         {10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1},
-         {2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1},
-         {7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1},
-         {7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1},
-         {2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1},
-         {1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1},
-         {11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1},
-         {8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1},
-         {0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1},
-         {7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
-         {10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
-         {2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
-         {6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1},
-         {7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1},
-         {2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1},
-         {1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1},
-         {10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1},
-         {10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1},
-         {0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1},
-         {7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1},
-         {6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1},
-         {8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1},
-         {9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1},
-         {6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1},
-         {4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1},
-         {10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1},
-         {8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1},
-         {0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1},
-         {1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1},
-         {8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1},
-         {10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1},
-         {4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1},
-         {10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
-         {5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
-         {11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1},
-         {9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
-         {6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1},
-         {7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1},
-         {3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1},
-         {7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1},
-         {9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1},
-         {3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1},
-         {6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1},
-         {9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1},
-         {1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1},
-         {4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1},
-         {7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1},
-         {6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1},
-         {3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1},
-         {0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1},
-         {6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1},
-         {0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1},
-         {11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1},
-         {6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1},
-         {5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1},
-         {9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
-         {1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1},
-         {1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1},
-         {10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1},
-         {0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1},
-         {5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1},
-         {10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1},
-         {11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1},
-         {9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1},
-         {7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1},
-         {2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1},
-         {8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1},
-         {9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1},
-         {9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1},
-         {1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1},
-         {9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1},
-         {9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1},
-         {5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1},
-         {0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1},
-         {10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1},
-         {2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1},
-         {0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1},
-         {0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1},
-         {9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1},
-         {5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1},
-         {3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1},
-         {5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1},
-         {8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1},
-         {9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1},
-         {0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1},
-         {1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1},
-         {3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1},
-         {4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1},
-         {9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1},
-         {11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1},
-         {11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1},
-         {2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1},
-         {9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1},
-         {3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1},
-         {1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1},
-         {4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1},
-         {4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1},
-         {0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1},
-         {3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1},
-         {3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1},
-         {0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1},
-         {9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1},
-         {1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-         {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}};
-
-Vector3r interpVertex(real isoLevel, const Vector3r& p1, const Vector3r& p2, real valp1, real valp2) {
-    if (abs(isoLevel - valp1) < 0.00001) return p1;
-    if (abs(isoLevel - valp2) < 0.00001) return p2;
-    if (abs(valp1 - valp2) < 0.00001) return p1;
-    real mu = (isoLevel - valp1) / (valp2 - valp1);
-    Vector3r p = p1 + mu * (p2 - p1);
-    return p;
-}
-
-TriangleMesh CubicLagrangeDiscreteGrid::marchingCubes(real isoLevel) {
-    auto& n = m_resolution;
-    auto vpos = [&](int i, int j, int k) { return (n[0] + 1)*(n[1] + 1)*k + (n[0] + 1)*j + i; };
-
-    std::vector<Vector3r> vertices;
-    std::vector<Eigen::Vector3i> indices;
-
-    size_t batch_size = 1024;
-    size_t n_batches = m_n_cells / batch_size;
-#pragma omp parallel for
-    for (auto bi = 0u; bi < n_batches; ++bi)
-    {
-        std::vector<Vector3r> vertices_buffer;
-        size_t ci_end = std::min(batch_size*(bi+1), m_n_cells);
-        for (size_t ci = batch_size*bi; ci < ci_end; ++ci) {
-            auto mi = singleToMultiIndex(ci);
-            real val[8];
-            int i = mi[0], j = mi[1], k = mi[2];
-            val[0] = m_nodes[0][vpos(i+0,j+0,k+0)];
-            val[1] = m_nodes[0][vpos(i+0,j+1,k+0)];
-            val[2] = m_nodes[0][vpos(i+1,j+1,k+0)];
-            val[3] = m_nodes[0][vpos(i+1,j+0,k+0)];
-            val[4] = m_nodes[0][vpos(i+0,j+0,k+1)];
-            val[5] = m_nodes[0][vpos(i+0,j+1,k+1)];
-            val[6] = m_nodes[0][vpos(i+1,j+1,k+1)];
-            val[7] = m_nodes[0][vpos(i+1,j+0,k+1)];
-
-            int cubeindex = 0;
-
-            if (val[0] < isoLevel) cubeindex |= 1;
-            if (val[1] < isoLevel) cubeindex |= 2;
-            if (val[2] < isoLevel) cubeindex |= 4;
-            if (val[3] < isoLevel) cubeindex |= 8;
-            if (val[4] < isoLevel) cubeindex |= 16;
-            if (val[5] < isoLevel) cubeindex |= 32;
-            if (val[6] < isoLevel) cubeindex |= 64;
-            if (val[7] < isoLevel) cubeindex |= 128;
-
-            /* Cube is entirely in/out of the surface */
-            if (edgeTable[cubeindex] == 0) continue;
-
-            Vector3r p[8];
-            p[0] = m_domain.min() + m_cell_size.cwiseProduct(Vector3r(i+0,j+0,k+0));
-            p[1] = m_domain.min() + m_cell_size.cwiseProduct(Vector3r(i+0,j+1,k+0));
-            p[2] = m_domain.min() + m_cell_size.cwiseProduct(Vector3r(i+1,j+1,k+0));
-            p[3] = m_domain.min() + m_cell_size.cwiseProduct(Vector3r(i+1,j+0,k+0));
-            p[4] = m_domain.min() + m_cell_size.cwiseProduct(Vector3r(i+0,j+0,k+1));
-            p[5] = m_domain.min() + m_cell_size.cwiseProduct(Vector3r(i+0,j+1,k+1));
-            p[6] = m_domain.min() + m_cell_size.cwiseProduct(Vector3r(i+1,j+1,k+1));
-            p[7] = m_domain.min() + m_cell_size.cwiseProduct(Vector3r(i+1,j+0,k+1));
-
-            Vector3r vertlist[12];
-
-            /* Find the vertices where the surface intersects the cube */
-            if (edgeTable[cubeindex] & 1)
-                vertlist[0] = interpVertex(isoLevel, p[0], p[1], val[0], val[1]);
-            if (edgeTable[cubeindex] & 2)
-                vertlist[1] = interpVertex(isoLevel, p[1], p[2], val[1], val[2]);
-            if (edgeTable[cubeindex] & 4)
-                vertlist[2] = interpVertex(isoLevel, p[2], p[3], val[2], val[3]);
-            if (edgeTable[cubeindex] & 8)
-                vertlist[3] = interpVertex(isoLevel, p[3], p[0], val[3], val[0]);
-            if (edgeTable[cubeindex] & 16)
-                vertlist[4] = interpVertex(isoLevel, p[4], p[5], val[4], val[5]);
-            if (edgeTable[cubeindex] & 32)
-                vertlist[5] = interpVertex(isoLevel, p[5], p[6], val[5], val[6]);
-            if (edgeTable[cubeindex] & 64)
-                vertlist[6] = interpVertex(isoLevel, p[6], p[7], val[6], val[7]);
-            if (edgeTable[cubeindex] & 128)
-                vertlist[7] = interpVertex(isoLevel, p[7], p[4], val[7], val[4]);
-            if (edgeTable[cubeindex] & 256)
-                vertlist[8] = interpVertex(isoLevel, p[0], p[4], val[0], val[4]);
-            if (edgeTable[cubeindex] & 512)
-                vertlist[9] = interpVertex(isoLevel, p[1], p[5], val[1], val[5]);
-            if (edgeTable[cubeindex] & 1024)
-                vertlist[10] = interpVertex(isoLevel, p[2], p[6], val[2], val[6]);
-            if (edgeTable[cubeindex] & 2048)
-                vertlist[11] = interpVertex(isoLevel, p[3], p[7], val[3], val[7]);
-
-            /* Create the triangle */
-            for (int t=0;triTable[cubeindex][t]!=-1;t+=3) {
-                vertices_buffer.push_back(vertlist[triTable[cubeindex][t  ]]);
-                vertices_buffer.push_back(vertlist[triTable[cubeindex][t+1]]);
-                vertices_buffer.push_back(vertlist[triTable[cubeindex][t+2]]);
-            }
-        }
-
-#pragma omp critical
-        vertices.insert(vertices.end(), vertices_buffer.begin(), vertices_buffer.end());
-    }
-
-    indices.resize(vertices.size()/3);
-    for (int i = 0; i < vertices.size()/3; i++) {
-        indices[i] = {3*i, 3*i+1, 3*i+2};
-    }
-
-    TriangleMesh trimesh(vertices, indices);
-    return trimesh;
+TriangleMesh CubicLagrangeDiscreteGrid::marchingCubes(int field_id, real isoLevel, int subdivision,
+	MinMaxPyramid const* pyramid)
+{
+	requireField(field_id);
+	auto field = field_view(m_nodes[field_id], m_cells[field_id], m_cell_map[field_id]);
+	return iso_surface::marchingCubes(*this, field, isoLevel, subdivision, pyramid);
+}
+
+std::vector<TriangleMesh> CubicLagrangeDiscreteGrid::marchingCubes(int field_id,
+	std::vector<real> const& isoLevels, int subdivision, MinMaxPyramid const* pyramid)
+{
+	requireField(field_id);
+	auto field = field_view(m_nodes[field_id], m_cells[field_id], m_cell_map[field_id]);
+	return iso_surface::marchingCubes(*this, field, isoLevels, subdivision, pyramid);
+}
+
+bool CubicLagrangeDiscreteGrid::streamMarchingCubes(std::string const& filename, MeshFileFormat format,
+	int field_id, real isoLevel, int subdivision, MinMaxPyramid const* pyramid)
+{
+	requireField(field_id);
+	MeshWriter writer(filename, format);
+	if (!writer.good())
+		return false;
+
+	auto field = field_view(m_nodes[field_id], m_cells[field_id], m_cell_map[field_id]);
+	auto extracted = iso_surface::marchingCubes(*this, field, std::vector<real>{isoLevel}, subdivision, pyramid,
+		[&](int, std::vector<Vector3r> const& vertices, std::vector<Eigen::Vector3i> const& faces)
+	{
+		writer.write(vertices, faces);
+		return writer.good();
+	});
+	return writer.close() && extracted;
+}
+
+TriangleMesh CubicLagrangeDiscreteGrid::dualContouring(int field_id, real isoLevel, int subdivision,
+	MinMaxPyramid const* pyramid)
+{
+	requireField(field_id);
+	auto field = field_view(m_nodes[field_id], m_cells[field_id], m_cell_map[field_id]);
+	return iso_surface::dualContouring(*this, field, isoLevel, subdivision, pyramid);
+}
+
+MinMaxPyramid CubicLagrangeDiscreteGrid::minMaxPyramid(int field_id) const
+{
+	requireField(field_id);
+	return iso_surface::minMaxPyramid(*this, field_view(m_nodes[field_id], m_cells[field_id], m_cell_map[field_id]));
 }
 
 } // namespace Discregrid
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <discrete_grid.hpp>
+#include <cell_map.hpp>
+
+namespace Discregrid
+{
+
+// Interpolation of the cubic Lagrange discretizations on raw arrays, shared by
+// the grids holding their fields in memory and the grids mapped from a file.
+namespace cubic_lagrange
+{
+
+// Data of a discretization. If cells is null, the cells are implied by the grid,
+// i.e. the field must not have been reduced.
+struct FieldView
+{
+	real const* nodes;
+	std::array<int, 32> const* cells;
+	CellMapView cell_map;
+};
+
+// Returns the nodes of cell l of a field that has not been reduced.
+std::array<int, 32> denseCell(Eigen::Vector3i const& resolution, int l);
+
+// Evaluates the shape functions of a cell at the reference coordinates xi in [-1, 1]^3.
+Eigen::Matrix<real, 32, 1> shapeFunctions(Vector3r const& xi, Eigen::Matrix<real, 32, 3>* dN = nullptr);
+
+bool determineShapeFunctions(DiscreteGrid const& grid, FieldView const& field,
+	Vector3r const& x, std::array<int, 32>& cell, Vector3r& c0, Eigen::Matrix<real, 32, 1>& N,
+	Eigen::Matrix<real, 32, 3>* dN);
+
+real interpolate(FieldView const& field, std::array<int, 32> const& cell, Vector3r const& c0,
+	Eigen::Matrix<real, 32, 1> const& N, Vector3r* gradient, Eigen::Matrix<real, 32, 3>* dN);
+
+real interpolate(DiscreteGrid const& grid, FieldView const& field, Vector3r const& x,
+	Vector3r* gradient);
+
+}
+}
@@ -12,13 +12,17 @@ using namespace Eigen;
 namespace Discregrid
 {
 
-MeshDistance::MeshDistance(const TriangleMesh* mesh, bool precompute_normals)
-	: m_bsh(mesh->vertex_data(), mesh->face_data()), m_mesh(mesh)
+MeshDistance::MeshDistance(const TriangleMesh* mesh, bool precompute_normals, Hierarchy hierarchy)
+	: m_mesh(mesh), m_hierarchy(hierarchy)
+	, m_bsh(mesh->vertex_data(), mesh->face_data()), m_wbbh(mesh->vertex_data(), mesh->face_data())
 	, m_precomputed_normals(precompute_normals)
 {
 	auto max_threads = omp_get_max_threads();
 
-	m_bsh.construct();
+	if (m_hierarchy == Hierarchy::WideBoxes)
+		m_wbbh.construct();
+	else
+		m_bsh.construct();
 
 	if (m_precomputed_normals)
 	{
@@ -57,9 +61,8 @@ real
 MeshDistance::distance(Vector3r const& x, Vector3r* nearest_point,
 	int* nearest_face, NearestEntity* ne) const
 {
-	using namespace std::placeholders;
-
 	auto dist_candidate = std::numeric_limits<real>::max();
+	auto nearest = -1;
 	auto pred = [&](int node_index, int)
 	{
 		return predicate(node_index, m_bsh, x, dist_candidate);
@@ -67,12 +70,11 @@ MeshDistance::distance(Vector3r const& x, Vector3r* nearest_point,
 
 	auto cb = [&](int node_index, int)
 	{
-		return callback(node_index, m_bsh, x, dist_candidate, *nearest_face);
+		callback(node_index, m_bsh, x, dist_candidate, nearest);
 	};
 
 	auto pless = [&](std::array<int, 2> const& c)
 	{
-		//return true;
 		auto const& hull0 = m_bsh.hull(c[0]);
 		auto const& hull1 = m_bsh.hull(c[1]);
 		auto d0_2 = (x - hull0.x()).norm() - hull0.r();
@@ -80,14 +82,38 @@ MeshDistance::distance(Vector3r const& x, Vector3r* nearest_point,
 		return d0_2 < d1_2;
 	};
 
-	m_bsh.traverseDepthFirst(pred, cb, pless);
+	if (m_hierarchy == Hierarchy::WideBoxes)
+	{
+		auto sq_dist = std::numeric_limits<real>::max();
+		m_wbbh.traverseNearestFirst(x, sq_dist, [&](int f)
+		{
+			auto t = std::array<Vector3r const*, 3>{
+				&m_mesh->vertex(m_mesh->faceVertex(f, 0)),
+				&m_mesh->vertex(m_mesh->faceVertex(f, 1)),
+				&m_mesh->vertex(m_mesh->faceVertex(f, 2))
+			};
+			auto dist2_ = point_triangle_sqdistance(x, t);
+			if (dist2_ < sq_dist)
+			{
+				sq_dist = dist2_;
+				nearest = f;
+			}
+		});
+		dist_candidate = std::sqrt(sq_dist);
+	}
+	else
+	{
+		m_bsh.traverseDepthFirstInline(pred, cb, pless);
+	}
+	if (nearest_face)
+		*nearest_face = nearest;
 
 	if (nearest_point)
 	{
 		auto t = std::array<Vector3r const*, 3>{
-			&m_mesh->vertex(m_mesh->faceVertex(*nearest_face, 0)),
-			&m_mesh->vertex(m_mesh->faceVertex(*nearest_face, 1)),
-			&m_mesh->vertex(m_mesh->faceVertex(*nearest_face, 2))
+			&m_mesh->vertex(m_mesh->faceVertex(nearest, 0)),
+			&m_mesh->vertex(m_mesh->faceVertex(nearest, 1)),
+			&m_mesh->vertex(m_mesh->faceVertex(nearest, 2))
 		};
 		auto np = Vector3r{};
 		auto ne_ = NearestEntity{};
@@ -178,34 +204,7 @@ MeshDistance::signedDistance(Vector3r const& x, Vector3r* nearest_point, Vector3
 	auto np = Vector3r{};
 	auto dist = distance(x, &np, &nf, &ne);
 	
-	auto n = Vector3r{};
-	switch (ne)
-	{
-	case NearestEntity::VN0:
-		n = vertex_normal(m_mesh->faceVertex(nf, 0));
-		break;
-	case NearestEntity::VN1:
-		n = vertex_normal(m_mesh->faceVertex(nf, 1));
-		break;
-	case NearestEntity::VN2:
-		n = vertex_normal(m_mesh->faceVertex(nf, 2));
-		break;
-	case NearestEntity::EN0:
-		n = edge_normal({static_cast<unsigned int>(nf), 0});
-		break;
-	case NearestEntity::EN1:
-		n = edge_normal({static_cast<unsigned int>(nf), 1});
-		break;
-	case NearestEntity::EN2:
-		n = edge_normal({static_cast<unsigned int>(nf), 2});
-		break;
-	case NearestEntity::FN:
-		n = face_normal(nf);
-		break;
-	default:
-		n.setZero();
-		break;
-	}
+	auto n = pseudo_normal(nf, ne);
 
 	if ((x - np).dot(n) < 0.0)
 		dist *= -1.0;
@@ -219,6 +218,48 @@ MeshDistance::signedDistance(Vector3r const& x, Vector3r* nearest_point, Vector3
 	return dist;
 }
 
+real
+MeshDistance::signedFaceDistance(Vector3r const& x, int f) const
+{
+	auto t = std::array<Vector3r const*, 3>{
+		&m_mesh->vertex(m_mesh->faceVertex(f, 0)),
+		&m_mesh->vertex(m_mesh->faceVertex(f, 1)),
+		&m_mesh->vertex(m_mesh->faceVertex(f, 2))
+	};
+	auto np = Vector3r{};
+	auto ne = NearestEntity{};
+	auto dist = std::sqrt(point_triangle_sqdistance(x, t, &np, &ne));
+
+	if ((x - np).dot(pseudo_normal(f, ne)) < 0.0)
+		dist *= -1.0;
+
+	return dist;
+}
+
+Vector3r
+MeshDistance::pseudo_normal(int f, NearestEntity ne) const
+{
+	switch (ne)
+	{
+	case NearestEntity::VN0:
+		return vertex_normal(m_mesh->faceVertex(f, 0));
+	case NearestEntity::VN1:
+		return vertex_normal(m_mesh->faceVertex(f, 1));
+	case NearestEntity::VN2:
+		return vertex_normal(m_mesh->faceVertex(f, 2));
+	case NearestEntity::EN0:
+		return edge_normal({static_cast<unsigned int>(f), 0});
+	case NearestEntity::EN1:
+		return edge_normal({static_cast<unsigned int>(f), 1});
+	case NearestEntity::EN2:
+		return edge_normal({static_cast<unsigned int>(f), 2});
+	case NearestEntity::FN:
+		return face_normal(f);
+	default:
+		return Vector3r::Zero();
+	}
+}
+
 real
 MeshDistance::unsignedDistance(Vector3r const & x) const
 {
@@ -0,0 +1,226 @@
+#include "grid_file_format.hpp"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Discregrid
+{
+
+namespace grid_file
+{
+
+namespace
+{
+
+uint64_t const prime1 = 0x9e3779b185ebca87u;
+uint64_t const prime2 = 0xc2b2ae3d27d4eb4fu;
+uint64_t const prime3 = 0x165667b19e3779f9u;
+std::size_t const checksum_block_size = 1u << 20;
+
+inline uint64_t
+rotl(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t
+load_word(char const* p)
+{
+	auto word = uint64_t{};
+	std::memcpy(&word, p, sizeof(word));
+	return word;
+}
+
+// Hashes a block of bytes in four interleaved lanes of 64 bit words.
+uint64_t
+hash_block(char const* data, std::size_t size, uint64_t seed)
+{
+	uint64_t lanes[4] = {seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+	auto p = data;
+	auto end = data + size;
+	for (; end - p >= 32; p += 32)
+	{
+		for (auto l = 0; l < 4; ++l)
+			lanes[l] = rotl(lanes[l] + load_word(p + 8 * l) * prime2, 31) * prime1;
+	}
+
+	auto h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18) + size;
+	for (; end - p >= 8; p += 8)
+		h = rotl(h ^ (load_word(p) * prime2), 27) * prime1 + prime3;
+	for (; p < end; ++p)
+		h = rotl(h ^ (static_cast<uint64_t>(static_cast<unsigned char>(*p)) * prime3), 11) * prime1;
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	return h ^ (h >> 32);
+}
+
+}
+
+uint64_t
+checksum(char const* data, std::size_t size)
+{
+	if (size <= checksum_block_size)
+		return hash_block(data, size, 0u);
+
+	// Hash the digests of independent blocks.
+	auto n_blocks = (size + checksum_block_size - 1u) / checksum_block_size;
+	auto digests = std::vector<uint64_t>(n_blocks);
+#pragma omp parallel for schedule(static)
+	for (int b = 0; b < static_cast<int>(n_blocks); ++b)
+	{
+		auto offset = static_cast<std::size_t>(b) * checksum_block_size;
+		digests[b] = hash_block(data + offset, std::min(checksum_block_size, size - offset), b);
+	}
+	return hash_block(reinterpret_cast<char const*>(digests.data()), n_blocks * sizeof(uint64_t), n_blocks);
+}
+
+uint64_t
+directoryChecksum(Header const& header, std::vector<FieldEntry> const& entries)
+{
+	auto bytes = std::vector<char>(sizeof(Header) + entries.size() * sizeof(FieldEntry));
+	auto copy = header;
+	copy.directory_checksum = 0u;
+	std::memcpy(bytes.data(), &copy, sizeof(Header));
+	if (!entries.empty())
+		std::memcpy(bytes.data() + sizeof(Header), entries.data(), entries.size() * sizeof(FieldEntry));
+	return checksum(bytes.data(), bytes.size());
+}
+
+char const*
+mapFile(std::string const& filename, std::size_t& size)
+{
+#ifdef _WIN32
+	auto file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+	auto file_size = LARGE_INTEGER{};
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+	// The view keeps the mapping and the file open.
+	auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return nullptr;
+	auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!data)
+		return nullptr;
+	size = static_cast<std::size_t>(file_size.QuadPart);
+	return static_cast<char const*>(data);
+#else
+	auto fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return nullptr;
+	}
+	// The mapping keeps the file open.
+	auto data = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return nullptr;
+	size = static_cast<std::size_t>(st.st_size);
+	return static_cast<char const*>(data);
+#endif
+}
+
+void
+unmapFile(char const* data, std::size_t size)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(const_cast<char*>(data), size);
+#endif
+}
+
+bool
+readDirectory(char const* data, std::size_t size, Header& header,
+	std::vector<FieldEntry>& entries)
+{
+	if (size < sizeof(header) || !std::equal(magic, magic + 8, data))
+	{
+		std::cerr << "ERROR: Discrete grid can not be read. Input file is not in the mappable format!" << std::endl;
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (header.version < min_version || header.version > version)
+	{
+		std::cerr << "ERROR: Discrete grid can not be read. File format version " << header.version
+			<< " is not supported!" << std::endl;
+		return false;
+	}
+	if (header.real_size != sizeof(real))
+	{
+		std::cerr << "ERROR: Discrete grid can not be read. File was saved with a different floating point precision!" << std::endl;
+		return false;
+	}
+
+	auto is_valid = [&](Section const& section)
+	{
+		return section.offset % section_alignment == 0u && section.offset <= size &&
+			section.size <= size - section.offset;
+	};
+
+	auto corrupted = header.compression > compressed ||
+		header.n_fields > (size - sizeof(header)) / sizeof(FieldEntry);
+	auto n_cells = uint64_t{1};
+	for (auto d = 0; d < 3 && !corrupted; ++d)
+	{
+		corrupted = header.resolution[d] <= 0;
+		n_cells *= static_cast<uint64_t>(header.resolution[d]);
+	}
+	corrupted = corrupted || header.n_cells != n_cells;
+
+	if (!corrupted)
+	{
+		entries.resize(static_cast<std::size_t>(header.n_fields));
+		if (!entries.empty())
+			std::memcpy(entries.data(), data + sizeof(header), entries.size() * sizeof(FieldEntry));
+		corrupted = directoryChecksum(header, entries) != header.directory_checksum;
+		for (auto const& entry : entries)
+		{
+			corrupted = corrupted || !is_valid(entry.nodes) || !is_valid(entry.cells) ||
+				!is_valid(entry.masks) || !is_valid(entry.block_offsets) || !is_valid(entry.cell_list);
+		}
+	}
+
+	if (corrupted)
+	{
+		std::cerr << "ERROR: Discrete grid can not be read. Input file is corrupted!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool
+isValidCellMap(Eigen::Vector3i const& resolution, std::size_t n_masks,
+	int const* offsets, std::size_t n_offsets, std::size_t n_cells)
+{
+	auto n_blocks = static_cast<std::size_t>(((resolution.array() + 3) / 4).cast<std::size_t>().prod());
+	return n_masks == n_blocks && n_offsets == n_blocks + 1u && offsets[n_blocks] >= 0 &&
+		static_cast<std::size_t>(offsets[n_blocks]) == n_cells;
+}
+
+}
+}
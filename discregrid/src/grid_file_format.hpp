@@ -0,0 +1,111 @@
+#pragma once
+
+#include <types.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace Discregrid
+{
+
+// Layout of the mappable grid file format. A file starts with a Header that is
+// followed by one FieldEntry per discretization. The arrays of the fields are
+// stored in sections whose offsets from the beginning of the file are multiples
+// of section_alignment, such that a mapped file can be accessed in place. If the
+// file is compressed, each section holds the array compressed by the codec in
+// utility/compression.hpp instead. The directory and every section are protected
+// by checksums, such that damaged files are detected when they are read.
+namespace grid_file
+{
+
+char const magic[8] = {'D', 'G', 'R', 'I', 'D', 'M', 'A', 'P'};
+uint32_t const version = 3u;
+// Oldest version that can still be read. Up to version 2, the cells of fields
+// that were not reduced are stored as well.
+uint32_t const min_version = 2u;
+uint64_t const section_alignment = 64u;
+
+enum Compression : uint32_t
+{
+	uncompressed = 0u,
+	compressed = 1u
+};
+
+// Byte range of an array in the file and the checksum of its bytes.
+struct Section
+{
+	uint64_t offset;
+	uint64_t size;
+	uint64_t checksum;
+};
+
+struct Header
+{
+	char magic[8];
+	uint32_t version;
+	// Size of the floating point type of the coefficients.
+	uint32_t real_size;
+	double domain_min[3];
+	double domain_max[3];
+	double cell_size[3];
+	double inv_cell_size[3];
+	int32_t resolution[3];
+	uint32_t compression;
+	uint64_t n_cells;
+	uint64_t n_fields;
+	// Checksum of the header and the field directory, see directoryChecksum.
+	uint64_t directory_checksum;
+};
+
+struct FieldEntry
+{
+	// Coefficients of the nodes (real).
+	Section nodes;
+	// Node indices of the stored cells (std::array<int, 32>). The section is empty
+	// for fields that were not reduced, whose cells are implied by the grid, see
+	// cubic_lagrange::denseCell.
+	Section cells;
+	// Compact cell map, see CellMap. The sections are empty for the identity.
+	Section masks;
+	Section block_offsets;
+	Section cell_list;
+	uint32_t identity;
+	uint32_t padding;
+};
+
+inline uint64_t
+alignSection(uint64_t offset)
+{
+	return (offset + section_alignment - 1u) / section_alignment * section_alignment;
+}
+
+// Checksum of an array of bytes. Large arrays are hashed in parallel.
+uint64_t checksum(char const* data, std::size_t size);
+
+// Checksum of the header, where directory_checksum is taken to be zero, followed
+// by the field directory.
+uint64_t directoryChecksum(Header const& header, std::vector<FieldEntry> const& entries);
+
+inline bool
+hasValidChecksum(char const* file, Section const& section)
+{
+	return checksum(file + section.offset, static_cast<std::size_t>(section.size)) == section.checksum;
+}
+
+// Maps the whole file read-only. Returns nullptr if the file can not be mapped.
+char const* mapFile(std::string const& filename, std::size_t& size);
+void unmapFile(char const* data, std::size_t size);
+
+// Reads and validates the header and the field directory of a file of the given
+// size, including the bounds of all sections. The checksums of the sections are
+// not verified.
+bool readDirectory(char const* data, std::size_t size, Header& header,
+	std::vector<FieldEntry>& entries);
+
+// Checks the sizes of the arrays of a compact cell map, see CellMap.
+bool isValidCellMap(Eigen::Vector3i const& resolution, std::size_t n_masks,
+	int const* offsets, std::size_t n_offsets, std::size_t n_cells);
+
+}
+}
@@ -0,0 +1,1248 @@
+#include "iso_surface.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+using namespace Eigen;
+
+namespace Discregrid
+{
+
+namespace iso_surface
+{
+
+namespace
+{
+
+int const edgeTable[256] = {
+        0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
+        0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
+        0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
+        0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
+        0x230, 0x339, 0x33 , 0x13a, 0x636, 0x73f, 0x435, 0x53c,
+        0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
+        0x3a0, 0x2a9, 0x1a3, 0xaa , 0x7a6, 0x6af, 0x5a5, 0x4ac,
+        0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
+        0x460, 0x569, 0x663, 0x76a, 0x66 , 0x16f, 0x265, 0x36c,
+        0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
+        0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0xff , 0x3f5, 0x2fc,
+        0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
+        0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x55 , 0x15c,
+        0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
+        0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0xcc ,
+        0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
+        0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
+        0xcc , 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
+        0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
+        0x15c, 0x55 , 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
+        0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
+        0x2fc, 0x3f5, 0xff , 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
+        0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
+        0x36c, 0x265, 0x16f, 0x66 , 0x76a, 0x663, 0x569, 0x460,
+        0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
+        0x4ac, 0x5a5, 0x6af, 0x7a6, 0xaa , 0x1a3, 0x2a9, 0x3a0,
+        0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
+        0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x33 , 0x339, 0x230,
+        0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
+        0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x99 , 0x190,
+        0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
+        0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0   };
+
+int const triTable[256][16] =
+        {{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1},
+         {3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1},
+         {3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+         {3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+         {9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1},
+         {9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
+         {2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1},
+         {8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+         {9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+         {4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1},
+         {3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1},
+         {1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1},
+         {4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1},
+         {4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+         {9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+         {5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+         {2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1},
+         {9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+         {0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+         {2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1},
+         {10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1},
+         {4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1},
+         {5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1},
+         {5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1},
+         {9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+         {0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+         {1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1},
+         {10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1},
+         {8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1},
+         {2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+         {7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1},
+         {9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1},
+         {2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1},
+         {11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+         {9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1},
+         {5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1},
+         {11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1},
+         {11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
+         {1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1},
+         {9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1},
+         {5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1},
+         {2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+         {0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
+         {5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1},
+         {6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1},
+         {3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
+         {6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1},
+         {5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1},
+         {1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
+         {10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1},
+         {6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1},
+         {8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1},
+         {7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1},
+         {3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+         {5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1},
+         {0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1},
+         {9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1},
+         {8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1},
+         {5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1},
+         {0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1},
+         {6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1},
+         {10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1},
+         {10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1},
+         {8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1},
+         {1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+         {3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1},
+         {0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1},
+         {10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1},
+         {3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1},
+         {6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1},
+         {9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1},
+         {8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1},
+         {3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+         {6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1},
+         {0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1},
+         {10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1},
+         {10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1},
+         {2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1},
+         {7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+         {7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1},
+         {2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1},
+         {1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1},
+         {11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1},
+         {8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1},
+         {0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1},
+         {7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
+         {10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
+         {2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
+         {6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1},
+         {7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+         {2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1},
+         {1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1},
+         {10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+         {10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1},
+         {0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1},
+         {7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+         {6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+         {8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1},
+         {9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1},
+         {6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1},
+         {4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1},
+         {10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1},
+         {8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+         {0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1},
+         {1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+         {8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1},
+         {10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+         {4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1},
+         {10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
+         {5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
+         {11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1},
+         {9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
+         {6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1},
+         {7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1},
+         {3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1},
+         {7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1},
+         {9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1},
+         {3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1},
+         {6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1},
+         {9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1},
+         {1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1},
+         {4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1},
+         {7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1},
+         {6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+         {3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1},
+         {0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1},
+         {6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1},
+         {0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1},
+         {11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1},
+         {6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1},
+         {5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1},
+         {9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+         {1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1},
+         {1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1},
+         {10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1},
+         {0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1},
+         {5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1},
+         {10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1},
+         {11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1},
+         {9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1},
+         {7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1},
+         {2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+         {8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1},
+         {9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1},
+         {9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1},
+         {1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+         {9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+         {9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1},
+         {5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1},
+         {0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1},
+         {10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1},
+         {2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1},
+         {0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1},
+         {0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1},
+         {9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1},
+         {5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+         {3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1},
+         {5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1},
+         {8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1},
+         {9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1},
+         {0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1},
+         {1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1},
+         {3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1},
+         {4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1},
+         {9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1},
+         {11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1},
+         {11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1},
+         {2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1},
+         {9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1},
+         {3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1},
+         {1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+         {4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1},
+         {4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1},
+         {0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1},
+         {3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1},
+         {3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1},
+         {0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+         {9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1},
+         {1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}};
+
+// Corners of a cube in the order of the tables, where edge e of the tables
+// connects the corners cube_edges[e].
+int const cube_corners[8][3] = {
+	{0, 0, 0}, {0, 1, 0}, {1, 1, 0}, {1, 0, 0},
+	{0, 0, 1}, {0, 1, 1}, {1, 1, 1}, {1, 0, 1}};
+int const cube_edges[12][2] = {
+	{0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6},
+	{6, 7}, {7, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+// Number of triangles per row of triTable.
+struct TriangleCounts
+{
+	TriangleCounts()
+	{
+		for (auto i = 0; i < 256; ++i)
+		{
+			auto t = 0;
+			while (triTable[i][t] != -1)
+				t += 3;
+			counts[i] = t / 3;
+		}
+	}
+
+	int operator[](int i) const { return counts[i]; }
+
+	int counts[256];
+};
+TriangleCounts const triangle_counts;
+
+Vector3r
+interpVertex(real isoLevel, Vector3r const& p1, Vector3r const& p2, real valp1, real valp2)
+{
+	if (std::abs(isoLevel - valp1) < 0.00001) return p1;
+	if (std::abs(isoLevel - valp2) < 0.00001) return p2;
+	if (std::abs(valp1 - valp2) < 0.00001) return p1;
+	real mu = (isoLevel - valp1) / (valp2 - valp1);
+	return p1 + mu * (p2 - p1);
+}
+
+// Loads the coefficients of cell l and returns whether they are all defined.
+bool
+loadCell(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field, int l,
+	Matrix<real, 32, 1>& coeffs)
+{
+	auto c = field.cell_map[l];
+	if (c == std::numeric_limits<int>::max())
+		return false;
+
+	auto cell = field.cells ? field.cells[c] : cubic_lagrange::denseCell(grid.resolution(), l);
+	for (auto v = 0; v < 32; ++v)
+	{
+		coeffs[v] = field.nodes[cell[v]];
+		if (coeffs[v] == std::numeric_limits<real>::max())
+			return false;
+	}
+	return true;
+}
+
+// Adds the cells (i + 1, j), (i, j + 1) and (i + 1, j + 1) of each cell ij of a
+// layer to the sorted cells.
+std::vector<int>
+dilateCells(Eigen::Vector3i const& n, std::vector<int> const& cells)
+{
+	auto dilated = std::vector<int>{};
+	dilated.reserve(4 * cells.size());
+	for (auto ij : cells)
+	{
+		auto i = ij % n[0];
+		auto j = ij / n[0];
+		for (auto b = 0; b <= (j + 1 < n[1] ? 1 : 0); ++b)
+			for (auto a = 0; a <= (i + 1 < n[0] ? 1 : 0); ++a)
+				dilated.push_back(ij + a + n[0] * b);
+	}
+	std::sort(dilated.begin(), dilated.end());
+	dilated.erase(std::unique(dilated.begin(), dilated.end()), dilated.end());
+	return dilated;
+}
+
+// Values of a field on the lattice of the corners of the sub-cells, which has
+// subdivision + 1 points per cell along each axis. A point shared by several
+// cells is evaluated in only one of them, namely the cell with the largest index
+// among those whose coefficients are all defined, such that neighboring cells
+// classify shared points consistently. Only the planes of points spanned by one
+// layer of cells are held at a time, where plane K is stored in slot
+// K % (subdivision + 1) such that consecutive layers share a plane.
+class SubLattice
+{
+public:
+
+	SubLattice(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field, int subdivision);
+
+	int subdivision() const { return m_s; }
+	// Number of points along each axis.
+	Eigen::Vector3i const& size() const { return m_size; }
+
+	bool loadCell(int l, Matrix<real, 32, 1>& coeffs) const
+	{
+		return iso_surface::loadCell(m_grid, m_field, l, coeffs);
+	}
+
+	// Whether the points of a cell whose coefficients lie within [min, max] may be
+	// on both sides of the iso-level.
+	bool mayIntersect(real min, real max, real iso_level) const;
+
+	// Evaluates the planes k * s, ..., (k + 1) * s of points spanned by the layer
+	// k of cells, where only the points of the cells ij in cells are required.
+	// The points of the cells ij in next_cells of layer k + 1 that lie in the
+	// shared plane are evaluated as well.
+	void evaluateLayer(int k, std::vector<int> const& cells, std::vector<int> const& next_cells);
+	real value(int I, int J, int K) const
+	{
+		return m_values[I + m_size[0] * (J + m_size[1] * static_cast<std::size_t>(K % (m_s + 1)))];
+	}
+
+	uint64_t pointIndex(int I, int J, int K) const
+	{
+		return static_cast<uint64_t>(I) + m_size[0] * (static_cast<uint64_t>(J) + m_size[1] * static_cast<uint64_t>(K));
+	}
+
+	Vector3r position(int I, int J, int K) const
+	{
+		return m_grid.domain().min() + m_grid.cellSize().cwiseProduct(Vector3r(I, J, K)) / m_s;
+	}
+
+private:
+
+	// Value at the point (a, b, c) of a cell with the given coefficients.
+	real evaluate(Matrix<real, 32, 1> const& coeffs, int a, int b, int c) const;
+	// Value at the point (I, J, K) for the case that the cell it is assigned to
+	// is not valid.
+	real evaluatePoint(int I, int J, int K) const;
+	// Evaluates the points with the offsets c_begin, ..., c_end from plane k * s
+	// that are assigned to the cells ij of layer k.
+	void evaluatePlanes(int k, int c_begin, int c_end, std::vector<int> const& cells);
+
+	DiscreteGrid const& m_grid;
+	cubic_lagrange::FieldView m_field;
+	int m_s;
+	Eigen::Vector3i m_size;
+	// Shape functions of a cell at its point (a, b, c) in row a + (s + 1) * (b + (s + 1) * c).
+	Matrix<real, Dynamic, 32, RowMajor> m_shape_functions;
+	// Maximum sum of the absolute values of the shape functions at the points.
+	real m_lebesgue_constant;
+	std::vector<real> m_values;
+};
+
+SubLattice::SubLattice(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field, int subdivision)
+	: m_grid(grid), m_field(field), m_s(subdivision)
+{
+	auto& n = grid.resolution();
+	auto s = m_s;
+	m_size = n * s + Eigen::Vector3i::Ones();
+
+	m_shape_functions.resize((s + 1) * (s + 1) * (s + 1), 32);
+	for (auto c = 0; c <= s; ++c)
+	{
+		for (auto b = 0; b <= s; ++b)
+		{
+			for (auto a = 0; a <= s; ++a)
+			{
+				auto xi = (Vector3r(a, b, c) * (2.0 / s) - Vector3r::Ones()).eval();
+				m_shape_functions.row(a + (s + 1) * (b + (s + 1) * c)) = cubic_lagrange::shapeFunctions(xi).transpose();
+			}
+		}
+	}
+	m_lebesgue_constant = m_shape_functions.cwiseAbs().rowwise().sum().maxCoeff();
+
+	m_values.resize(static_cast<std::size_t>(m_size[0]) * m_size[1] * (s + 1));
+}
+
+bool
+SubLattice::mayIntersect(real min, real max, real iso_level) const
+{
+	// As the shape functions sum up to one, the value at a point deviates from the
+	// center m of the coefficients by at most the Lebesgue constant times the
+	// radius r, up to rounding errors.
+	auto m = static_cast<real>(0.5) * (min + max);
+	auto r = static_cast<real>(0.5) * (max - min);
+	auto bound = m_lebesgue_constant * r +
+		64 * std::numeric_limits<real>::epsilon() * m_lebesgue_constant * (std::abs(m) + r);
+	return m - bound < iso_level && m + bound >= iso_level;
+}
+
+real
+SubLattice::evaluate(Matrix<real, 32, 1> const& coeffs, int a, int b, int c) const
+{
+	// The interpolant equals the coefficient of the vertex node at the corners.
+	auto s = m_s;
+	if (a % s == 0 && b % s == 0 && c % s == 0)
+		return coeffs[a / s + 2 * (b / s) + 4 * (c / s)];
+	return (m_shape_functions.row(a + (s + 1) * (b + (s + 1) * c)) * coeffs).value();
+}
+
+real
+SubLattice::evaluatePoint(int I, int J, int K) const
+{
+	// The cells containing the point are visited in descending order of their index.
+	auto& n = m_grid.resolution();
+	auto s = m_s;
+	auto candidates = [s](int I, int n_cells, int ci[2])
+	{
+		ci[0] = std::min(I / s, n_cells - 1);
+		ci[1] = I % s == 0 && I / s - 1 >= 0 && I / s - 1 != ci[0] ? I / s - 1 : -1;
+	};
+	int ci[2], cj[2], ck[2];
+	candidates(I, n[0], ci);
+	candidates(J, n[1], cj);
+	candidates(K, n[2], ck);
+
+	auto coeffs = Matrix<real, 32, 1>{};
+	for (auto k : ck)
+	{
+		for (auto j : cj)
+		{
+			for (auto i : ci)
+			{
+				if (i < 0 || j < 0 || k < 0)
+					continue;
+				if (loadCell(i + n[0] * (j + n[1] * k), coeffs))
+					return evaluate(coeffs, I - s * i, J - s * j, K - s * k);
+			}
+		}
+	}
+	return std::numeric_limits<real>::max();
+}
+
+void
+SubLattice::evaluatePlanes(int k, int c_begin, int c_end, std::vector<int> const& cells)
+{
+	// Each point is assigned to the cell with the largest index containing it,
+	// hence every point of a plane is written by exactly one cell.
+	auto& n = m_grid.resolution();
+	auto s = m_s;
+#pragma omp parallel for schedule(static)
+	for (int x = 0; x < static_cast<int>(cells.size()); ++x)
+	{
+		auto ij = cells[x];
+		auto i = ij % n[0];
+		auto j = ij / n[0];
+		auto coeffs = Matrix<real, 32, 1>{};
+		auto valid = loadCell(ij + n[0] * n[1] * k, coeffs);
+
+		auto a_end = i == n[0] - 1 ? s : s - 1;
+		auto b_end = j == n[1] - 1 ? s : s - 1;
+		for (auto c = c_begin; c <= c_end; ++c)
+		{
+			auto K = k * s + c;
+			auto plane = static_cast<std::size_t>(K % (s + 1));
+			for (auto b = 0; b <= b_end; ++b)
+			{
+				for (auto a = 0; a <= a_end; ++a)
+				{
+					auto I = i * s + a;
+					auto J = j * s + b;
+					m_values[I + m_size[0] * (J + m_size[1] * plane)] =
+						valid ? evaluate(coeffs, a, b, c) : evaluatePoint(I, J, K);
+				}
+			}
+		}
+	}
+}
+
+void
+SubLattice::evaluateLayer(int k, std::vector<int> const& cells, std::vector<int> const& next_cells)
+{
+	// The points of a cell are assigned to the cell itself and to its neighbors
+	// in positive direction.
+	auto& n = m_grid.resolution();
+	auto s = m_s;
+	auto writers = dilateCells(n, cells);
+
+	// The lowest plane has been evaluated as the highest plane of the previous layer.
+	if (k == 0)
+		evaluatePlanes(0, 0, 0, writers);
+
+	// The highest plane is assigned to the next layer unless this is the last one.
+	evaluatePlanes(k, 1, k == n[2] - 1 ? s : s - 1, writers);
+	if (k + 1 < n[2])
+	{
+		auto shared = std::vector<int>{};
+		std::set_union(cells.begin(), cells.end(), next_cells.begin(), next_cells.end(),
+			std::back_inserter(shared));
+		evaluatePlanes(k + 1, 0, 0, dilateCells(n, shared));
+	}
+}
+
+// Selects the cells of the layers whose coefficients are defined and may be on
+// both sides of any of the iso-levels. If a pyramid is given, only the cells of
+// its blocks that may contain an iso-level are candidates.
+class ActiveCells
+{
+public:
+
+	ActiveCells(DiscreteGrid const& grid, SubLattice const& lattice, std::vector<real> const& iso_levels,
+		MinMaxPyramid const* pyramid);
+
+	// Returns the active cells ij of layer k in ascending order and, if requested,
+	// the range of the coefficients of each of them.
+	std::vector<int> layer(int k, std::vector<std::array<real, 2>>* ranges = nullptr) const;
+
+private:
+
+	bool mayIntersect(real min, real max) const
+	{
+		return std::any_of(m_iso_levels.begin(), m_iso_levels.end(), [&](real iso_level)
+		{
+			return m_lattice.mayIntersect(min, max, iso_level);
+		});
+	}
+
+	DiscreteGrid const& m_grid;
+	SubLattice const& m_lattice;
+	std::vector<real> m_iso_levels;
+	MinMaxPyramid const* m_pyramid;
+	std::vector<int> m_blocks;
+};
+
+ActiveCells::ActiveCells(DiscreteGrid const& grid, SubLattice const& lattice,
+	std::vector<real> const& iso_levels, MinMaxPyramid const* pyramid)
+	: m_grid(grid), m_lattice(lattice), m_iso_levels(iso_levels), m_pyramid(pyramid)
+{
+	if (pyramid)
+	{
+		m_blocks = pyramid->findBlocks([&](real min, real max)
+		{
+			return mayIntersect(min, max);
+		});
+	}
+}
+
+std::vector<int>
+ActiveCells::layer(int k, std::vector<std::array<real, 2>>* ranges) const
+{
+	auto& n = m_grid.resolution();
+	auto n_layer_cells = n[0] * n[1];
+	auto candidates = std::vector<int>{};
+	if (m_pyramid)
+	{
+		auto bs = MinMaxPyramid::blockSize();
+		auto& r = m_pyramid->resolution(0);
+		auto first = std::lower_bound(m_blocks.begin(), m_blocks.end(), k / bs * r[0] * r[1]);
+		auto last = std::lower_bound(first, m_blocks.end(), (k / bs + 1) * r[0] * r[1]);
+		for (auto b = first; b != last; ++b)
+		{
+			for (auto l : m_pyramid->blockCells(*b))
+			{
+				if (l / n_layer_cells == k)
+					candidates.push_back(l % n_layer_cells);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+	}
+	else
+	{
+		candidates.resize(n_layer_cells);
+		std::iota(candidates.begin(), candidates.end(), 0);
+	}
+
+	auto active = std::vector<char>(candidates.size());
+	auto candidate_ranges = std::vector<std::array<real, 2>>(candidates.size());
+#pragma omp parallel for schedule(static)
+	for (int x = 0; x < static_cast<int>(candidates.size()); ++x)
+	{
+		auto coeffs = Matrix<real, 32, 1>{};
+		active[x] = m_lattice.loadCell(candidates[x] + n_layer_cells * k, coeffs);
+		if (active[x])
+		{
+			candidate_ranges[x] = {{coeffs.minCoeff(), coeffs.maxCoeff()}};
+			active[x] = mayIntersect(candidate_ranges[x][0], candidate_ranges[x][1]);
+		}
+	}
+	auto cells = std::vector<int>{};
+	if (ranges)
+		ranges->clear();
+	for (auto x = 0u; x < candidates.size(); ++x)
+	{
+		if (active[x])
+		{
+			cells.push_back(candidates[x]);
+			if (ranges)
+				ranges->push_back(candidate_ranges[x]);
+		}
+	}
+	return cells;
+}
+
+bool
+matchesGrid(DiscreteGrid const& grid, MinMaxPyramid const* pyramid)
+{
+	if (pyramid && pyramid->cellResolution() != grid.resolution())
+	{
+		std::cerr << "ERROR: The min/max pyramid does not match the resolution of the grid!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Classifies the sub-cells of cell (i, j, k) by the corners below the iso-level
+// and returns the number of triangles within them.
+int
+classifyCell(SubLattice const& lattice, int i, int j, int k, real iso_level, unsigned char* cube_indices)
+{
+	auto s = lattice.subdivision();
+	auto n_triangles = 0;
+	for (auto c = 0; c < s; ++c)
+	{
+		for (auto b = 0; b < s; ++b)
+		{
+			for (auto a = 0; a < s; ++a)
+			{
+				auto I = i * s + a;
+				auto J = j * s + b;
+				auto K = k * s + c;
+				auto cubeindex = 0;
+				for (auto v = 0; v < 8; ++v)
+				{
+					auto const* d = cube_corners[v];
+					if (lattice.value(I + d[0], J + d[1], K + d[2]) < iso_level)
+						cubeindex |= 1 << v;
+				}
+				*cube_indices++ = static_cast<unsigned char>(cubeindex);
+				n_triangles += triangle_counts[cubeindex];
+			}
+		}
+	}
+	return n_triangles;
+}
+
+// Writes the intersected edges of the triangles of the classified sub-cells of
+// cell (i, j, k) to edges, where an edge is identified by 3 * the index of its
+// first point + its axis.
+void
+polygonizeCell(SubLattice const& lattice, int i, int j, int k, unsigned char const* cube_indices,
+	uint64_t* edges)
+{
+	auto s = lattice.subdivision();
+	for (auto c = 0; c < s; ++c)
+	{
+		for (auto b = 0; b < s; ++b)
+		{
+			for (auto a = 0; a < s; ++a)
+			{
+				auto cubeindex = *cube_indices++;
+				for (int t = 0; triTable[cubeindex][t] != -1; ++t)
+				{
+					auto const* d0 = cube_corners[cube_edges[triTable[cubeindex][t]][0]];
+					auto const* d1 = cube_corners[cube_edges[triTable[cubeindex][t]][1]];
+					auto axis = d0[0] != d1[0] ? 0 : d0[1] != d1[1] ? 1 : 2;
+					auto point = lattice.pointIndex(i * s + a + std::min(d0[0], d1[0]),
+						j * s + b + std::min(d0[1], d1[1]), k * s + c + std::min(d0[2], d1[2]));
+					*edges++ = 3u * point + axis;
+				}
+			}
+		}
+	}
+}
+
+// Minimizes the sum of the squared distances to the planes through the points
+// with the given normals. Directions in which the planes are nearly parallel are
+// fixed at the mass point of the points. The minimizer is clamped to box.
+Vector3r
+solveQef(Vector3r const* points, Vector3r const* normals, int n_points, AlignedBox3r const& box)
+{
+	auto mass_point = Vector3r::Zero().eval();
+	for (auto i = 0; i < n_points; ++i)
+		mass_point += points[i];
+	mass_point /= static_cast<real>(n_points);
+
+	auto ata = Matrix3r::Zero().eval();
+	auto atb = Vector3r::Zero().eval();
+	for (auto i = 0; i < n_points; ++i)
+	{
+		ata += normals[i] * normals[i].transpose();
+		atb += normals[i] * normals[i].dot(points[i] - mass_point);
+	}
+
+	// The eigenvalues are sorted in increasing order.
+	Eigen::SelfAdjointEigenSolver<Matrix3r> solver(ata);
+	auto const& lambda = solver.eigenvalues();
+	auto x = mass_point;
+	for (auto i = 0; i < 3; ++i)
+	{
+		if (lambda[i] > static_cast<real>(0.1) * lambda[2])
+		{
+			auto v = solver.eigenvectors().col(i);
+			x += v * (v.dot(atb) / lambda[i]);
+		}
+	}
+	return x.cwiseMax(box.min()).cwiseMin(box.max());
+}
+
+// Places the vertex of the intersected sub-cell (I, J, K) of cell (i, j, k) with
+// the given coefficients, whose corners are classified by cubeindex, at the
+// minimizer of the planes tangent to the surface at the intersected edges.
+Vector3r
+dualVertex(DiscreteGrid const& grid, SubLattice const& lattice, Matrix<real, 32, 1> const& coeffs,
+	int i, int j, int k, int I, int J, int K, int cubeindex, real iso_level)
+{
+	auto cell_min = (grid.domain().min() + grid.cellSize().cwiseProduct(Vector3r(i, j, k))).eval();
+	auto dxi_dx = Vector3r::Constant(2.0).cwiseQuotient(grid.cellSize()).eval();
+
+	Vector3r points[12];
+	Vector3r normals[12];
+	auto n_points = 0;
+	auto dN = Matrix<real, 32, 3>{};
+	for (auto e = 0; e < 12; ++e)
+	{
+		auto v0 = cube_edges[e][0];
+		auto v1 = cube_edges[e][1];
+		if (((cubeindex >> v0) & 1) == ((cubeindex >> v1) & 1))
+			continue;
+
+		auto const* d0 = cube_corners[v0];
+		auto const* d1 = cube_corners[v1];
+		auto x = interpVertex(iso_level,
+			lattice.position(I + d0[0], J + d0[1], K + d0[2]), lattice.position(I + d1[0], J + d1[1], K + d1[2]),
+			lattice.value(I + d0[0], J + d0[1], K + d0[2]), lattice.value(I + d1[0], J + d1[1], K + d1[2]));
+		auto xi = ((x - cell_min).cwiseProduct(dxi_dx) - Vector3r::Ones()).eval();
+		cubic_lagrange::shapeFunctions(xi, &dN);
+		auto gradient = (dN.transpose() * coeffs).cwiseProduct(dxi_dx).eval();
+		auto norm = gradient.norm();
+
+		points[n_points] = x;
+		normals[n_points] = norm > 0.0 ? (gradient / norm).eval() : Vector3r::Zero().eval();
+		++n_points;
+	}
+
+	return solveQef(points, normals, n_points,
+		AlignedBox3r(lattice.position(I, J, K), lattice.position(I + 1, J + 1, K + 1)));
+}
+
+// Polygonizes the layers of cells one after another at an iso-level, where the
+// vertices in the plane shared by consecutive layers are created only once.
+class LayerPolygonizer
+{
+public:
+
+	LayerPolygonizer(DiscreteGrid const& grid, SubLattice const& lattice, real iso_level)
+		: m_grid(grid), m_lattice(lattice), m_iso_level(iso_level) {}
+
+	// Polygonizes the cells ij of layer k, whose points have been evaluated, where
+	// the vertices are numbered across all layers.
+	void polygonize(int k, std::vector<int> const& cells);
+
+	// Vertices created for and triangles of the last polygonized layer.
+	std::vector<Vector3r> const& vertices() const { return m_vertices; }
+	std::vector<Eigen::Vector3i> const& faces() const { return m_faces; }
+
+private:
+
+	DiscreteGrid const& m_grid;
+	SubLattice const& m_lattice;
+	real m_iso_level;
+
+	int m_n_vertices = 0;
+	std::vector<Vector3r> m_vertices;
+	std::vector<Eigen::Vector3i> m_faces;
+	// Intersected edges in the plane shared with the previous layer of cells and
+	// their vertices, sorted by edge.
+	std::vector<uint64_t> m_shared_edges;
+	std::vector<int> m_shared_vertices;
+
+	// The triangles of a layer are counted per cell first, such that each cell
+	// writes its triangles to a fixed range in the order of the cells.
+	std::vector<unsigned char> m_cube_indices;
+	std::vector<int> m_offsets;
+	std::vector<uint64_t> m_edges;
+};
+
+void
+LayerPolygonizer::polygonize(int k, std::vector<int> const& cells)
+{
+	auto& n = m_grid.resolution();
+	auto s = m_lattice.subdivision();
+	auto& size = m_lattice.size();
+	auto plane_size = static_cast<uint64_t>(size[0]) * size[1];
+	auto n_sub_cells = s * s * s;
+	m_n_vertices += static_cast<int>(m_vertices.size());
+
+	auto n_cells = static_cast<int>(cells.size());
+	m_cube_indices.resize(static_cast<std::size_t>(n_cells) * n_sub_cells);
+	m_offsets.resize(n_cells + 1);
+#pragma omp parallel for schedule(static)
+	for (int x = 0; x < n_cells; ++x)
+	{
+		m_offsets[x + 1] = classifyCell(m_lattice, cells[x] % n[0], cells[x] / n[0], k, m_iso_level,
+			&m_cube_indices[static_cast<std::size_t>(x) * n_sub_cells]);
+	}
+	m_offsets[0] = 0;
+	std::partial_sum(m_offsets.begin(), m_offsets.end(), m_offsets.begin());
+
+	m_edges.resize(3u * m_offsets.back());
+#pragma omp parallel for schedule(static)
+	for (int x = 0; x < n_cells; ++x)
+	{
+		if (m_offsets[x + 1] > m_offsets[x])
+			polygonizeCell(m_lattice, cells[x] % n[0], cells[x] / n[0], k,
+				&m_cube_indices[static_cast<std::size_t>(x) * n_sub_cells], &m_edges[3u * m_offsets[x]]);
+	}
+	// Each intersected edge is assigned one vertex, where the vertices in the
+	// lowest plane may have been created by the previous layer.
+	auto layer_edges = m_edges;
+	std::sort(layer_edges.begin(), layer_edges.end());
+	layer_edges.erase(std::unique(layer_edges.begin(), layer_edges.end()), layer_edges.end());
+	auto layer_vertices = std::vector<int>(layer_edges.size());
+	auto new_edges = std::vector<int>{};
+	for (auto e = 0u; e < layer_edges.size(); ++e)
+	{
+		auto shared = std::lower_bound(m_shared_edges.begin(), m_shared_edges.end(), layer_edges[e]);
+		if (shared != m_shared_edges.end() && *shared == layer_edges[e])
+		{
+			layer_vertices[e] = m_shared_vertices[shared - m_shared_edges.begin()];
+			continue;
+		}
+		layer_vertices[e] = m_n_vertices + static_cast<int>(new_edges.size());
+		new_edges.push_back(e);
+	}
+
+	m_vertices.resize(new_edges.size());
+#pragma omp parallel for schedule(static)
+	for (int v = 0; v < static_cast<int>(new_edges.size()); ++v)
+	{
+		auto edge = layer_edges[new_edges[v]];
+		auto axis = static_cast<int>(edge % 3u);
+		auto point = edge / 3u;
+		auto I = static_cast<int>(point % size[0]);
+		auto J = static_cast<int>(point / size[0] % size[1]);
+		auto K = static_cast<int>(point / plane_size);
+		auto d = Eigen::Vector3i::Unit(axis);
+		m_vertices[v] = interpVertex(m_iso_level,
+			m_lattice.position(I, J, K), m_lattice.position(I + d[0], J + d[1], K + d[2]),
+			m_lattice.value(I, J, K), m_lattice.value(I + d[0], J + d[1], K + d[2]));
+	}
+
+	m_faces.resize(m_edges.size() / 3u);
+#pragma omp parallel for schedule(static)
+	for (int f = 0; f < static_cast<int>(m_edges.size() / 3u); ++f)
+	{
+		for (auto v = 0; v < 3; ++v)
+		{
+			auto e = std::lower_bound(layer_edges.begin(), layer_edges.end(), m_edges[3 * f + v]) - layer_edges.begin();
+			m_faces[f][v] = layer_vertices[e];
+		}
+	}
+
+	// Only edges in the highest plane are shared with the next layer.
+	auto first_shared = std::lower_bound(layer_edges.begin(), layer_edges.end(),
+		3u * plane_size * static_cast<uint64_t>((k + 1) * s)) - layer_edges.begin();
+	m_shared_edges.assign(layer_edges.begin() + first_shared, layer_edges.end());
+	m_shared_vertices.assign(layer_vertices.begin() + first_shared, layer_vertices.end());
+}
+
+} // namespace
+
+MinMaxPyramid
+minMaxPyramid(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field)
+{
+	return MinMaxPyramid(grid.resolution(), [&](int l, real& min, real& max) -> bool
+	{
+		auto coeffs = Matrix<real, 32, 1>{};
+		if (!loadCell(grid, field, l, coeffs))
+			return false;
+		min = coeffs.minCoeff();
+		max = coeffs.maxCoeff();
+		return true;
+	});
+}
+
+std::vector<TriangleMesh>
+marchingCubes(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field,
+	std::vector<real> const& iso_levels, int subdivision, MinMaxPyramid const* pyramid)
+{
+	auto vertices = std::vector<std::vector<Vector3r>>(iso_levels.size());
+	auto faces = std::vector<std::vector<Eigen::Vector3i>>(iso_levels.size());
+	marchingCubes(grid, field, iso_levels, subdivision, pyramid, [&](int level,
+		std::vector<Vector3r> const& layer_vertices, std::vector<Eigen::Vector3i> const& layer_faces)
+	{
+		vertices[level].insert(vertices[level].end(), layer_vertices.begin(), layer_vertices.end());
+		faces[level].insert(faces[level].end(), layer_faces.begin(), layer_faces.end());
+		return true;
+	});
+
+	auto meshes = std::vector<TriangleMesh>{};
+	for (auto level = 0u; level < iso_levels.size(); ++level)
+		meshes.emplace_back(vertices[level], faces[level]);
+	return meshes;
+}
+
+TriangleMesh
+marchingCubes(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field, real iso_level,
+	int subdivision, MinMaxPyramid const* pyramid)
+{
+	return std::move(marchingCubes(grid, field, std::vector<real>{iso_level}, subdivision, pyramid)[0]);
+}
+
+bool
+marchingCubes(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field,
+	std::vector<real> const& iso_levels, int subdivision, MinMaxPyramid const* pyramid,
+	LayerCallback const& callback)
+{
+	auto& n = grid.resolution();
+	if (!matchesGrid(grid, pyramid))
+		return false;
+
+	auto s = std::max(subdivision, 1);
+	SubLattice lattice(grid, field, s);
+	ActiveCells active_cells(grid, lattice, iso_levels, pyramid);
+	auto polygonizers = std::vector<LayerPolygonizer>{};
+	for (auto iso_level : iso_levels)
+		polygonizers.emplace_back(grid, lattice, iso_level);
+
+	// The points of a layer are evaluated once for the cells active at any level,
+	// which are then classified per level.
+	auto ranges = std::vector<std::array<real, 2>>{};
+	auto next_ranges = std::vector<std::array<real, 2>>{};
+	auto level_cells = std::vector<int>{};
+	auto next_cells = n[2] > 0 ? active_cells.layer(0, &next_ranges) : std::vector<int>{};
+	for (auto k = 0; k < n[2]; ++k)
+	{
+		auto cells = std::move(next_cells);
+		ranges.swap(next_ranges);
+		next_cells = k + 1 < n[2] ? active_cells.layer(k + 1, &next_ranges) : std::vector<int>{};
+		if (!cells.empty() || !next_cells.empty())
+			lattice.evaluateLayer(k, cells, next_cells);
+
+		for (auto level = 0u; level < iso_levels.size(); ++level)
+		{
+			level_cells.clear();
+			for (auto x = 0u; x < cells.size(); ++x)
+			{
+				if (lattice.mayIntersect(ranges[x][0], ranges[x][1], iso_levels[level]))
+					level_cells.push_back(cells[x]);
+			}
+
+			auto& polygonizer = polygonizers[level];
+			polygonizer.polygonize(k, level_cells);
+			if (!polygonizer.faces().empty() &&
+				!callback(static_cast<int>(level), polygonizer.vertices(), polygonizer.faces()))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+TriangleMesh
+dualContouring(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field, real iso_level,
+	int subdivision, MinMaxPyramid const* pyramid)
+{
+	auto& n = grid.resolution();
+	if (!matchesGrid(grid, pyramid))
+		return TriangleMesh(std::vector<Vector3r>{}, std::vector<Eigen::Vector3i>{});
+
+	auto s = std::max(subdivision, 1);
+	SubLattice lattice(grid, field, s);
+	ActiveCells active_cells(grid, lattice, std::vector<real>{iso_level}, pyramid);
+	auto& size = lattice.size();
+	auto plane_size = static_cast<uint64_t>(size[0]) * size[1];
+
+	auto vertices = std::vector<Vector3r>{};
+	auto faces = std::vector<Eigen::Vector3i>{};
+	// Intersected sub-cells, identified by the index of their lowest corner, and
+	// their vertices, sorted by sub-cell.
+	using SubCellVertex = std::pair<uint64_t, int>;
+	auto layer_sub_cells = std::vector<SubCellVertex>{};
+	// Intersected sub-cells of the highest plane of sub-cells of the previous layer.
+	auto shared_sub_cells = std::vector<SubCellVertex>{};
+
+	auto n_sub_cells = s * s * s;
+	auto cube_indices = std::vector<unsigned char>{};
+	auto offsets = std::vector<int>{};
+
+	// Returns the vertex of sub-cell (I, J, K) of layer k or the previous one or -1
+	// if the sub-cell is not intersected.
+	auto k = 0;
+	auto subCellVertex = [&](int I, int J, int K) -> int
+	{
+		if (I < 0 || J < 0 || K < 0)
+			return -1;
+		auto const& sub_cells = K < k * s ? shared_sub_cells : layer_sub_cells;
+		auto key = SubCellVertex(lattice.pointIndex(I, J, K), -1);
+		auto it = std::lower_bound(sub_cells.begin(), sub_cells.end(), key);
+		return it != sub_cells.end() && it->first == key.first ? it->second : -1;
+	};
+
+	// Each intersected edge of the lattice yields a quad connecting the vertices
+	// of the four sub-cells sharing it. The quad is emitted by the sub-cell whose
+	// lowest corner is the first point of the edge, as the other three sub-cells
+	// precede it. Writes the triangles of the quads of cell ij of layer k to
+	// triangles if given and returns their number.
+	auto triangulateCell = [&](int ij, unsigned char const* cube_indices, Eigen::Vector3i* triangles) -> int
+	{
+		// Corners following the lowest corner along each axis.
+		int const next_corner[3] = {3, 1, 4};
+		auto n_triangles = 0;
+		auto i = ij % n[0];
+		auto j = ij / n[0];
+		for (auto c = 0; c < s; ++c)
+		{
+			for (auto b = 0; b < s; ++b)
+			{
+				for (auto a = 0; a < s; ++a)
+				{
+					auto cubeindex = *cube_indices++;
+					if (cubeindex == 0 || cubeindex == 255)
+						continue;
+
+					auto P = Eigen::Vector3i(i * s + a, j * s + b, k * s + c);
+					auto inside = (cubeindex & 1) != 0;
+					for (auto axis = 0; axis < 3; ++axis)
+					{
+						if (((cubeindex >> next_corner[axis]) & 1) == (cubeindex & 1))
+							continue;
+
+						// The quad is counter-clockwise around the axis if it points
+						// from the inside to the outside.
+						auto eu = Eigen::Vector3i::Unit((axis + 1) % 3);
+						auto ev = Eigen::Vector3i::Unit((axis + 2) % 3);
+						Eigen::Vector3i corners[4] = {P - eu - ev, P - ev, P, P - eu};
+						int quad[4];
+						auto complete = true;
+						for (auto v = 0; v < 4 && complete; ++v)
+						{
+							quad[v] = subCellVertex(corners[v][0], corners[v][1], corners[v][2]);
+							complete = quad[v] >= 0;
+						}
+						if (!complete)
+							continue;
+						if (!inside)
+							std::swap(quad[1], quad[3]);
+
+						if (triangles)
+						{
+							// The quad is split along its shorter diagonal.
+							auto d02 = (vertices[quad[0]] - vertices[quad[2]]).squaredNorm();
+							auto d13 = (vertices[quad[1]] - vertices[quad[3]]).squaredNorm();
+							auto o = d02 <= d13 ? 0 : 1;
+							*triangles++ = Eigen::Vector3i(quad[o], quad[o + 1], quad[(o + 2) % 4]);
+							*triangles++ = Eigen::Vector3i(quad[o], quad[(o + 2) % 4], quad[(o + 3) % 4]);
+						}
+						n_triangles += 2;
+					}
+				}
+			}
+		}
+		return n_triangles;
+	};
+
+	auto next_cells = n[2] > 0 ? active_cells.layer(0) : std::vector<int>{};
+	for (k = 0; k < n[2]; ++k)
+	{
+		auto cells = std::move(next_cells);
+		next_cells = k + 1 < n[2] ? active_cells.layer(k + 1) : std::vector<int>{};
+		if (cells.empty() && next_cells.empty())
+		{
+			shared_sub_cells.clear();
+			continue;
+		}
+		lattice.evaluateLayer(k, cells, next_cells);
+
+		// The intersected sub-cells of a layer are counted per cell first, such
+		// that their vertices are ordered by cell.
+		auto n_cells = static_cast<int>(cells.size());
+		cube_indices.resize(static_cast<std::size_t>(n_cells) * n_sub_cells);
+		offsets.resize(n_cells + 1);
+#pragma omp parallel for schedule(static)
+		for (int x = 0; x < n_cells; ++x)
+		{
+			auto indices = &cube_indices[static_cast<std::size_t>(x) * n_sub_cells];
+			classifyCell(lattice, cells[x] % n[0], cells[x] / n[0], k, iso_level, indices);
+			offsets[x + 1] = static_cast<int>(std::count_if(indices, indices + n_sub_cells,
+				[](unsigned char cubeindex) { return cubeindex != 0 && cubeindex != 255; }));
+		}
+		offsets[0] = 0;
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		auto n_vertices = static_cast<int>(vertices.size());
+		vertices.resize(n_vertices + offsets.back());
+		layer_sub_cells.resize(offsets.back());
+#pragma omp parallel for schedule(static)
+		for (int x = 0; x < n_cells; ++x)
+		{
+			auto i = cells[x] % n[0];
+			auto j = cells[x] / n[0];
+			auto coeffs = Matrix<real, 32, 1>{};
+			lattice.loadCell(cells[x] + n[0] * n[1] * k, coeffs);
+			auto cubeindex = &cube_indices[static_cast<std::size_t>(x) * n_sub_cells];
+			auto v = offsets[x];
+			for (auto c = 0; c < s; ++c)
+			{
+				for (auto b = 0; b < s; ++b)
+				{
+					for (auto a = 0; a < s; ++a, ++cubeindex)
+					{
+						if (*cubeindex == 0 || *cubeindex == 255)
+							continue;
+						auto I = i * s + a;
+						auto J = j * s + b;
+						auto K = k * s + c;
+						vertices[n_vertices + v] = dualVertex(grid, lattice, coeffs, i, j, k, I, J, K, *cubeindex, iso_level);
+						layer_sub_cells[v] = SubCellVertex(lattice.pointIndex(I, J, K), n_vertices + v);
+						++v;
+					}
+				}
+			}
+		}
+		std::sort(layer_sub_cells.begin(), layer_sub_cells.end());
+
+#pragma omp parallel for schedule(static)
+		for (int x = 0; x < n_cells; ++x)
+			offsets[x + 1] = triangulateCell(cells[x], &cube_indices[static_cast<std::size_t>(x) * n_sub_cells], nullptr);
+		offsets[0] = 0;
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		auto n_faces = faces.size();
+		faces.resize(n_faces + offsets.back());
+#pragma omp parallel for schedule(static)
+		for (int x = 0; x < n_cells; ++x)
+		{
+			if (offsets[x + 1] > offsets[x])
+				triangulateCell(cells[x], &cube_indices[static_cast<std::size_t>(x) * n_sub_cells], &faces[n_faces + offsets[x]]);
+		}
+
+		// Only sub-cells in the highest plane of sub-cells are adjacent to the next layer.
+		auto first_shared = std::lower_bound(layer_sub_cells.begin(), layer_sub_cells.end(),
+			SubCellVertex(plane_size * static_cast<uint64_t>((k + 1) * s - 1), -1));
+		shared_sub_cells.assign(first_shared, layer_sub_cells.end());
+	}
+
+	return TriangleMesh(vertices, faces);
+}
+
+}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "cubic_lagrange_interpolation.hpp"
+
+#include <acceleration/min_max_pyramid.hpp>
+#include <mesh/triangle_mesh.hpp>
+
+#include <functional>
+
+namespace Discregrid
+{
+
+// Extraction of iso-surfaces from the cubic Lagrange discretizations, shared by
+// the grids holding their fields in memory and the grids mapped from a file.
+namespace iso_surface
+{
+
+// Bounds the coefficients of the cells of a field, see MinMaxPyramid.
+MinMaxPyramid minMaxPyramid(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field);
+
+// Extracts the iso-surface of a field by marching cubes, where each cell is
+// polygonized on a lattice of subdivision^3 sub-cells. Vertices on edges of the
+// lattice are shared by all triangles incident to them. If a pyramid of the
+// field is given, only the cells of its blocks that may contain the iso-level
+// are visited.
+TriangleMesh marchingCubes(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field,
+	real iso_level, int subdivision, MinMaxPyramid const* pyramid);
+
+// Extracts the iso-surfaces of several iso-levels as marchingCubes above in a
+// single pass over the cells, which are loaded and evaluated once for all
+// levels. Returns one mesh per level.
+std::vector<TriangleMesh> marchingCubes(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field,
+	std::vector<real> const& iso_levels, int subdivision, MinMaxPyramid const* pyramid);
+
+// Receives the vertices created for a layer of cells and the triangles of the
+// layer of the iso-surface of iso_levels[level], which refer to the vertices of
+// the layer and of all previous layers of the same surface by their index in the
+// order of creation. Returning false stops the extraction.
+using LayerCallback = std::function<bool(int level, std::vector<Vector3r> const& vertices,
+	std::vector<Eigen::Vector3i> const& faces)>;
+
+// Extracts the iso-surfaces as marchingCubes above, but passes the meshes to the
+// callback layer by layer instead of collecting them. Layers without triangles
+// are not passed. Returns false if the extraction was stopped.
+bool marchingCubes(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field,
+	std::vector<real> const& iso_levels, int subdivision, MinMaxPyramid const* pyramid,
+	LayerCallback const& callback);
+
+// Extracts the iso-surface of a field by dual contouring on the same lattice of
+// sub-cells, where each intersected sub-cell is assigned a vertex minimizing the
+// distances to the tangent planes at its intersected edges. Each intersected
+// edge of the lattice yields a quad, which is split into two triangles.
+TriangleMesh dualContouring(DiscreteGrid const& grid, cubic_lagrange::FieldView const& field,
+	real iso_level, int subdivision, MinMaxPyramid const* pyramid);
+
+}
+}
@@ -0,0 +1,239 @@
+#include "mapped_cubic_lagrange_discrete_grid.hpp"
+#include "cubic_lagrange_interpolation.hpp"
+#include "grid_file_format.hpp"
+
+#include <iostream>
+#include <fstream>
+
+namespace Discregrid
+{
+
+MappedCubicLagrangeDiscreteGrid::MappedCubicLagrangeDiscreteGrid(std::string const& filename)
+{
+	load(filename);
+}
+
+MappedCubicLagrangeDiscreteGrid::MappedCubicLagrangeDiscreteGrid(MappedCubicLagrangeDiscreteGrid&& other)
+	: DiscreteGrid(other), m_data(other.m_data), m_size(other.m_size), m_owns_data(other.m_owns_data),
+	m_fields(std::move(other.m_fields))
+{
+	other.m_data = nullptr;
+	other.m_size = 0u;
+	other.m_fields.clear();
+}
+
+MappedCubicLagrangeDiscreteGrid&
+MappedCubicLagrangeDiscreteGrid::operator=(MappedCubicLagrangeDiscreteGrid&& other)
+{
+	if (this != &other)
+	{
+		unmap();
+		DiscreteGrid::operator=(other);
+		m_data = other.m_data;
+		m_size = other.m_size;
+		m_owns_data = other.m_owns_data;
+		m_fields = std::move(other.m_fields);
+		other.m_data = nullptr;
+		other.m_size = 0u;
+		other.m_fields.clear();
+	}
+	return *this;
+}
+
+MappedCubicLagrangeDiscreteGrid::~MappedCubicLagrangeDiscreteGrid()
+{
+	unmap();
+}
+
+void
+MappedCubicLagrangeDiscreteGrid::unmap()
+{
+	if (m_data && m_owns_data)
+		grid_file::unmapFile(m_data, m_size);
+	m_data = nullptr;
+	m_size = 0u;
+	m_fields.clear();
+}
+
+void
+MappedCubicLagrangeDiscreteGrid::save(std::string const& filename) const
+{
+	if (!m_data)
+	{
+		std::cerr << "ERROR: Discrete grid can not be saved. No file is mapped!" << std::endl;
+		return;
+	}
+
+	auto out = std::ofstream(filename, std::ios::binary);
+	out.write(m_data, static_cast<std::streamsize>(m_size));
+	out.close();
+}
+
+bool
+MappedCubicLagrangeDiscreteGrid::verifyChecksums() const
+{
+	auto header = grid_file::Header{};
+	auto entries = std::vector<grid_file::FieldEntry>{};
+	if (!m_data || !grid_file::readDirectory(m_data, m_size, header, entries))
+		return false;
+
+	for (auto const& entry : entries)
+	{
+		if (!grid_file::hasValidChecksum(m_data, entry.nodes) ||
+			(entry.cells.size > 0u && !grid_file::hasValidChecksum(m_data, entry.cells)) ||
+			(!entry.identity && (!grid_file::hasValidChecksum(m_data, entry.masks) ||
+			!grid_file::hasValidChecksum(m_data, entry.block_offsets) ||
+			!grid_file::hasValidChecksum(m_data, entry.cell_list))))
+			return false;
+	}
+	return true;
+}
+
+void
+MappedCubicLagrangeDiscreteGrid::load(std::string const& filename)
+{
+	unmap();
+
+	auto size = std::size_t{};
+	auto data = grid_file::mapFile(filename, size);
+	if (!data)
+	{
+		std::cerr << "ERROR: Discrete grid can not be mapped. Input file does not exist or is empty!" << std::endl;
+		return;
+	}
+	attach(data, size, true);
+}
+
+void
+MappedCubicLagrangeDiscreteGrid::loadFromMemory(void const* data, std::size_t size)
+{
+	unmap();
+
+	// The sections are aligned relative to the beginning of the grid.
+	if (reinterpret_cast<std::uintptr_t>(data) % alignof(uint64_t) != 0u)
+	{
+		std::cerr << "ERROR: Discrete grid can not be mapped. Buffer is not aligned to " << alignof(uint64_t)
+			<< " bytes!" << std::endl;
+		return;
+	}
+	attach(static_cast<char const*>(data), size, false);
+}
+
+void
+MappedCubicLagrangeDiscreteGrid::attach(char const* data, std::size_t size, bool owns_data)
+{
+	m_data = data;
+	m_size = size;
+	m_owns_data = owns_data;
+
+	auto header = grid_file::Header{};
+	auto entries = std::vector<grid_file::FieldEntry>{};
+	if (!grid_file::readDirectory(m_data, m_size, header, entries))
+	{
+		unmap();
+		return;
+	}
+	if (header.compression != grid_file::uncompressed)
+	{
+		std::cerr << "ERROR: Discrete grid can not be mapped. Compressed files have to be loaded!" << std::endl;
+		unmap();
+		return;
+	}
+
+	m_resolution = Eigen::Vector3i(header.resolution[0], header.resolution[1], header.resolution[2]);
+	m_domain = AlignedBox3r(
+		Eigen::Vector3d(header.domain_min[0], header.domain_min[1], header.domain_min[2]).cast<real>(),
+		Eigen::Vector3d(header.domain_max[0], header.domain_max[1], header.domain_max[2]).cast<real>());
+	m_cell_size = Eigen::Vector3d(header.cell_size[0], header.cell_size[1], header.cell_size[2]).cast<real>();
+	m_inv_cell_size = Eigen::Vector3d(header.inv_cell_size[0], header.inv_cell_size[1],
+		header.inv_cell_size[2]).cast<real>();
+	m_n_cells = header.n_cells;
+	m_n_fields = header.n_fields;
+
+	auto corrupted = false;
+	for (auto const& entry : entries)
+	{
+		if (entry.nodes.size % sizeof(real) != 0u || entry.cells.size % sizeof(std::array<int, 32>) != 0u)
+		{
+			corrupted = true;
+			break;
+		}
+
+		auto field = Field{};
+		field.nodes = std::span<real const>(reinterpret_cast<real const*>(m_data + entry.nodes.offset),
+			entry.nodes.size / sizeof(real));
+		// Fields without stored cells keep a null span, such that their cells are
+		// computed from the resolution instead of read from the file.
+		if (entry.cells.size > 0u)
+		{
+			field.cells = std::span<std::array<int, 32> const>(
+				reinterpret_cast<std::array<int, 32> const*>(m_data + entry.cells.offset),
+				entry.cells.size / sizeof(std::array<int, 32>));
+		}
+
+		if (entry.identity)
+		{
+			// The cells of fields that were not reduced are computed on the fly
+			// unless they are stored.
+			field.cell_map = CellMapView(m_resolution);
+			corrupted = !field.cells.empty() && field.cells.size() != m_n_cells;
+		}
+		else
+		{
+			auto offsets = reinterpret_cast<int const*>(m_data + entry.block_offsets.offset);
+			corrupted = entry.block_offsets.size == 0u || !grid_file::isValidCellMap(m_resolution,
+				entry.masks.size / sizeof(uint64_t), offsets, entry.block_offsets.size / sizeof(int),
+				entry.cell_list.size / sizeof(int));
+			field.cell_map = CellMapView(m_resolution,
+				reinterpret_cast<uint64_t const*>(m_data + entry.masks.offset), offsets,
+				reinterpret_cast<int const*>(m_data + entry.cell_list.offset));
+		}
+		if (corrupted)
+			break;
+		m_fields.push_back(field);
+	}
+
+	if (corrupted)
+	{
+		std::cerr << "ERROR: Discrete grid can not be mapped. Input file is corrupted!" << std::endl;
+		unmap();
+	}
+}
+
+int
+MappedCubicLagrangeDiscreteGrid::addFunction(ContinuousFunction const&, bool,
+	SamplePredicate const&)
+{
+	std::cerr << "ERROR: Functions can not be added to a mapped discrete grid!" << std::endl;
+	return -1;
+}
+
+bool
+MappedCubicLagrangeDiscreteGrid::determineShapeFunctions(int field_id, Vector3r const &x,
+	std::array<int, 32> &cell, Vector3r &c0, Eigen::Matrix<real, 32, 1> &N,
+	Eigen::Matrix<real, 32, 3> *dN) const
+{
+	auto const& f = m_fields[field_id];
+	auto field = cubic_lagrange::FieldView{f.nodes.data(), f.cells.data(), f.cell_map};
+	return cubic_lagrange::determineShapeFunctions(*this, field, x, cell, c0, N, dN);
+}
+
+real
+MappedCubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const&, const std::array<int, 32> &cell, const Vector3r &c0, const Eigen::Matrix<real, 32, 1> &N,
+	Vector3r* gradient, Eigen::Matrix<real, 32, 3> *dN) const
+{
+	auto const& f = m_fields[field_id];
+	auto field = cubic_lagrange::FieldView{f.nodes.data(), f.cells.data(), f.cell_map};
+	return cubic_lagrange::interpolate(field, cell, c0, N, gradient, dN);
+}
+
+real
+MappedCubicLagrangeDiscreteGrid::interpolate(int field_id, Vector3r const &x,
+	Vector3r *gradient) const
+{
+	auto const& f = m_fields[field_id];
+	auto field = cubic_lagrange::FieldView{f.nodes.data(), f.cells.data(), f.cell_map};
+	return cubic_lagrange::interpolate(*this, field, x, gradient);
+}
+
+}
@@ -0,0 +1,209 @@
+#include "mesh_writer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+using namespace Eigen;
+
+namespace Discregrid
+{
+
+namespace
+{
+
+// Number of vertices or faces formatted as text by one thread at a time.
+int const chunk_size = 1 << 14;
+
+// Width of the element counts in the header of a PLY file, which are written
+// with leading zeros and overwritten once the mesh is complete.
+int const count_width = 20;
+
+bool
+isLittleEndian()
+{
+	auto one = std::uint16_t{1};
+	return *reinterpret_cast<unsigned char const*>(&one) == 1;
+}
+
+void
+writeCount(std::ostream& out, std::size_t count)
+{
+	char digits[count_width + 1];
+	std::snprintf(digits, sizeof(digits), "%0*llu", count_width, static_cast<unsigned long long>(count));
+	out.write(digits, count_width);
+}
+
+}
+
+MeshWriter::MeshWriter(std::string const& filename, MeshFileFormat format)
+	: m_filename(filename), m_format(format)
+{
+	m_out.open(filename, std::ios::binary);
+	if (!m_out.good())
+	{
+		std::cerr << "ERROR: Mesh can not be written. Output file can not be opened!" << std::endl;
+		return;
+	}
+
+	if (format == MeshFileFormat::PLY)
+	{
+		m_faces_filename = filename + ".faces.tmp";
+		m_faces_out.open(m_faces_filename, std::ios::binary);
+		if (!m_faces_out.good())
+		{
+			std::cerr << "ERROR: Mesh can not be written. Temporary file can not be opened!" << std::endl;
+			return;
+		}
+
+		auto type = sizeof(real) == sizeof(double) ? "double" : "float";
+		m_out << "ply\n"
+			<< "format " << (isLittleEndian() ? "binary_little_endian" : "binary_big_endian") << " 1.0\n"
+			<< "element vertex ";
+		m_n_vertices_pos = m_out.tellp();
+		writeCount(m_out, 0u);
+		m_out << "\n"
+			<< "property " << type << " x\n"
+			<< "property " << type << " y\n"
+			<< "property " << type << " z\n"
+			<< "element face ";
+		m_n_faces_pos = m_out.tellp();
+		writeCount(m_out, 0u);
+		m_out << "\n"
+			<< "property list uchar int vertex_indices\n"
+			<< "end_header\n";
+	}
+	else
+	{
+		m_out << "g default\n";
+	}
+	m_good = m_out.good();
+}
+
+MeshWriter::~MeshWriter()
+{
+	if (m_faces_out.is_open())
+	{
+		m_faces_out.close();
+		std::remove(m_faces_filename.c_str());
+	}
+}
+
+void
+MeshWriter::write(std::vector<Vector3r> const& vertices, std::vector<Vector3i> const& faces)
+{
+	if (!m_good)
+		return;
+
+	if (m_format == MeshFileFormat::PLY)
+		writePLY(vertices, faces);
+	else
+		writeOBJ(vertices, faces);
+	m_n_vertices += vertices.size();
+	m_n_faces += faces.size();
+	m_good = m_out.good() && (m_format != MeshFileFormat::PLY || m_faces_out.good());
+	if (!m_good)
+		std::cerr << "ERROR: Mesh can not be written. Writing the output file failed!" << std::endl;
+}
+
+void
+MeshWriter::writeOBJ(std::vector<Vector3r> const& vertices, std::vector<Vector3i> const& faces)
+{
+	// The lines are formatted in chunks in parallel and written in order.
+	auto n_vertex_chunks = (static_cast<int>(vertices.size()) + chunk_size - 1) / chunk_size;
+	auto n_face_chunks = (static_cast<int>(faces.size()) + chunk_size - 1) / chunk_size;
+	m_chunks.resize(n_vertex_chunks + n_face_chunks);
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int c = 0; c < n_vertex_chunks + n_face_chunks; ++c)
+	{
+		auto& chunk = m_chunks[c];
+		chunk.clear();
+		char line[128];
+		if (c < n_vertex_chunks)
+		{
+			auto end = std::min(static_cast<std::size_t>(c + 1) * chunk_size, vertices.size());
+			for (auto v = static_cast<std::size_t>(c) * chunk_size; v < end; ++v)
+			{
+				auto n = std::snprintf(line, sizeof(line), "v %.*g %.*g %.*g\n",
+					std::numeric_limits<real>::max_digits10, static_cast<double>(vertices[v][0]),
+					std::numeric_limits<real>::max_digits10, static_cast<double>(vertices[v][1]),
+					std::numeric_limits<real>::max_digits10, static_cast<double>(vertices[v][2]));
+				chunk.append(line, n);
+			}
+		}
+		else
+		{
+			auto first = static_cast<std::size_t>(c - n_vertex_chunks) * chunk_size;
+			auto end = std::min(first + chunk_size, faces.size());
+			for (auto f = first; f < end; ++f)
+			{
+				auto n = std::snprintf(line, sizeof(line), "f %llu %llu %llu\n",
+					static_cast<unsigned long long>(faces[f][0]) + 1u,
+					static_cast<unsigned long long>(faces[f][1]) + 1u,
+					static_cast<unsigned long long>(faces[f][2]) + 1u);
+				chunk.append(line, n);
+			}
+		}
+	}
+
+	for (auto const& chunk : m_chunks)
+		m_out.write(chunk.data(), chunk.size());
+}
+
+void
+MeshWriter::writePLY(std::vector<Vector3r> const& vertices, std::vector<Vector3i> const& faces)
+{
+	m_out.write(reinterpret_cast<char const*>(vertices.data()), vertices.size() * sizeof(Vector3r));
+
+	// Each face is stored as its number of vertices followed by their indices.
+	auto const face_bytes = 1u + 3u * sizeof(std::int32_t);
+	m_buffer.resize(faces.size() * face_bytes);
+#pragma omp parallel for schedule(static)
+	for (int f = 0; f < static_cast<int>(faces.size()); ++f)
+	{
+		auto record = &m_buffer[f * face_bytes];
+		std::int32_t indices[3] = {faces[f][0], faces[f][1], faces[f][2]};
+		record[0] = 3;
+		std::memcpy(record + 1, indices, sizeof(indices));
+	}
+	m_faces_out.write(m_buffer.data(), m_buffer.size());
+}
+
+bool
+MeshWriter::close()
+{
+	if (m_format == MeshFileFormat::PLY && m_faces_out.is_open())
+	{
+		m_faces_out.close();
+		if (m_good)
+		{
+			auto in = std::ifstream(m_faces_filename, std::ios::binary);
+			m_buffer.resize(std::size_t{1} << 24);
+			while (in)
+			{
+				in.read(m_buffer.data(), m_buffer.size());
+				m_out.write(m_buffer.data(), in.gcount());
+			}
+			m_out.seekp(m_n_vertices_pos);
+			writeCount(m_out, m_n_vertices);
+			m_out.seekp(m_n_faces_pos);
+			writeCount(m_out, m_n_faces);
+			m_out.seekp(0, std::ios::end);
+		}
+		std::remove(m_faces_filename.c_str());
+	}
+
+	m_out.close();
+	if (m_good && !m_out)
+	{
+		std::cerr << "ERROR: Mesh can not be written. Writing the output file failed!" << std::endl;
+		m_good = false;
+	}
+	return m_good;
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <mesh/triangle_mesh.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Discregrid
+{
+
+// Writes an indexed triangle mesh to a file in parts, e.g. while the mesh is
+// generated, such that it is never held in memory as a whole. The faces of a
+// part may refer to the vertices of the same and all previous parts by their
+// index in the order in which they were written.
+class MeshWriter
+{
+public:
+
+	MeshWriter(std::string const& filename, MeshFileFormat format);
+	~MeshWriter();
+
+	bool good() const { return m_good; }
+
+	void write(std::vector<Vector3r> const& vertices, std::vector<Eigen::Vector3i> const& faces);
+
+	// Completes the file and returns whether it was written successfully.
+	bool close();
+
+private:
+
+	void writeOBJ(std::vector<Vector3r> const& vertices, std::vector<Eigen::Vector3i> const& faces);
+	void writePLY(std::vector<Vector3r> const& vertices, std::vector<Eigen::Vector3i> const& faces);
+
+	std::string m_filename;
+	MeshFileFormat m_format;
+	std::ofstream m_out;
+	bool m_good = false;
+	std::size_t m_n_vertices = 0u;
+	std::size_t m_n_faces = 0u;
+
+	// The faces of a PLY file follow all vertices, hence they are written to a
+	// temporary file and the counts in the header are filled in on completion.
+	std::string m_faces_filename;
+	std::ofstream m_faces_out;
+	std::streampos m_n_vertices_pos;
+	std::streampos m_n_faces_pos;
+
+	std::vector<std::string> m_chunks;
+	std::vector<char> m_buffer;
+};
+
+}
@@ -140,7 +140,7 @@ TriangleMesh::exportOBJ(std::string const& filename) const
 		outfile << "f";
 		for (int i = 0; i < 3; i++)
 			outfile << " " << f[i] + 1;
-		outfile << std::endl;
+		outfile << "\n";
 	}
 
 	outfile.close();
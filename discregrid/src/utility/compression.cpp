@@ -0,0 +1,421 @@
+#include "compression.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+
+namespace Discregrid
+{
+
+namespace compression
+{
+
+namespace
+{
+
+struct StreamHeader
+{
+	uint64_t n_rows;
+	uint32_t n_columns;
+	uint32_t chunk_rows;
+	uint32_t value_size;
+	uint32_t padding;
+};
+
+std::size_t const block_size = 32u;
+std::size_t const chunk_values = 1u << 16;
+
+template <std::size_t N> struct WordOf;
+template <> struct WordOf<4> { using type = uint32_t; };
+template <> struct WordOf<8> { using type = uint64_t; };
+
+template <typename T>
+using Word = typename WordOf<sizeof(T)>::type;
+
+template <typename T>
+Word<T>
+to_word(T value)
+{
+	auto word = Word<T>{};
+	std::memcpy(&word, &value, sizeof(T));
+	return word;
+}
+
+template <typename T>
+T
+from_word(Word<T> word)
+{
+	auto value = T{};
+	std::memcpy(&value, &word, sizeof(T));
+	return value;
+}
+
+// Evaluates base + (plus - minus) without multiplication to prevent contraction
+// into fused operations. Floating point results that are not finite fall back to
+// base, such that the decoder reproduces the bit pattern on any platform.
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, Word<T>>::type
+extrapolate(Word<T> base, Word<T> plus, Word<T> minus)
+{
+	auto vb = from_word<T>(base);
+	auto p = vb + (from_word<T>(plus) - from_word<T>(minus));
+	return std::isfinite(p) ? to_word(p) : base;
+}
+
+template <typename T>
+typename std::enable_if<!std::is_floating_point<T>::value, Word<T>>::type
+extrapolate(Word<T> base, Word<T> plus, Word<T> minus)
+{
+	return base + (plus - minus);
+}
+
+enum Predictor
+{
+	previous = 0,
+	linear = 1,
+	parallelogram = 2
+};
+
+// Predicts the value in row r and column j of a chunk starting at row_begin from
+// the values preceding it in the coding order, i.e. the previous rows of the
+// column and the previous columns of the chunk. The previous value and the
+// linear extrapolation follow the column, while the parallelogram rule adds the
+// difference of the previous row to the value of the previous column.
+template <typename T>
+Word<T>
+predict(T const* values, std::size_t n_columns, std::size_t row_begin, std::size_t r,
+	std::size_t j, int predictor)
+{
+	auto at = [&](std::size_t row, std::size_t column) { return to_word(values[row * n_columns + column]); };
+	auto a = r > row_begin ? at(r - 1, j) : Word<T>{0};
+	switch (predictor)
+	{
+	case previous:
+		return a;
+	case linear:
+		return extrapolate<T>(a, a, r > row_begin + 1 ? at(r - 2, j) : Word<T>{0});
+	default:
+		return extrapolate<T>(at(r, j - 1), a, r > row_begin ? at(r - 1, j - 1) : Word<T>{0});
+	}
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, Word<T>>::type
+residual(Word<T> x, Word<T> p)
+{
+	return x ^ p;
+}
+
+template <typename T>
+typename std::enable_if<!std::is_floating_point<T>::value, Word<T>>::type
+residual(Word<T> x, Word<T> p)
+{
+	auto d = x - p;
+	return (d << 1) ^ (Word<T>{0} - (d >> (8 * sizeof(T) - 1)));
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, Word<T>>::type
+reconstruct(Word<T> r, Word<T> p)
+{
+	return r ^ p;
+}
+
+template <typename T>
+typename std::enable_if<!std::is_floating_point<T>::value, Word<T>>::type
+reconstruct(Word<T> r, Word<T> p)
+{
+	return ((r >> 1) ^ (Word<T>{0} - (r & 1u))) + p;
+}
+
+template <typename W>
+int
+bit_width(W value)
+{
+	auto width = 0;
+	while (value)
+	{
+		value >>= 1;
+		++width;
+	}
+	return width;
+}
+
+class BitWriter
+{
+public:
+
+	explicit BitWriter(std::vector<char>& out) : m_out(out) {}
+
+	void put(uint64_t value, int bits)
+	{
+		if (bits > 32)
+		{
+			put32(value & 0xffffffffu, 32);
+			put32(value >> 32, bits - 32);
+		}
+		else
+			put32(value, bits);
+	}
+
+	void flush()
+	{
+		if (m_n > 0)
+			m_out.push_back(static_cast<char>(m_acc & 0xffu));
+		m_acc = 0u;
+		m_n = 0;
+	}
+
+private:
+
+	void put32(uint64_t value, int bits)
+	{
+		m_acc |= value << m_n;
+		m_n += bits;
+		while (m_n >= 8)
+		{
+			m_out.push_back(static_cast<char>(m_acc & 0xffu));
+			m_acc >>= 8;
+			m_n -= 8;
+		}
+	}
+
+	std::vector<char>& m_out;
+	uint64_t m_acc = 0u;
+	int m_n = 0;
+};
+
+class BitReader
+{
+public:
+
+	BitReader(char const* begin, char const* end) : m_p(begin), m_end(end) {}
+
+	uint64_t get(int bits)
+	{
+		if (bits > 32)
+		{
+			auto low = get32(32);
+			return low | (get32(bits - 32) << 32);
+		}
+		return get32(bits);
+	}
+
+	bool failed() const { return m_failed; }
+
+private:
+
+	uint64_t get32(int bits)
+	{
+		while (m_n < bits)
+		{
+			if (m_p == m_end)
+			{
+				m_failed = true;
+				return 0u;
+			}
+			m_acc |= static_cast<uint64_t>(static_cast<unsigned char>(*m_p++)) << m_n;
+			m_n += 8;
+		}
+		auto value = m_acc & ((uint64_t{1} << bits) - 1u);
+		m_acc >>= bits;
+		m_n -= bits;
+		return value;
+	}
+
+	char const* m_p;
+	char const* m_end;
+	uint64_t m_acc = 0u;
+	int m_n = 0;
+	bool m_failed = false;
+};
+
+// Encodes the rows [row_begin, row_end) column by column.
+template <typename T>
+void
+compress_chunk(T const* values, std::size_t n_columns, std::size_t row_begin,
+	std::size_t row_end, std::vector<char>& out)
+{
+	auto writer = BitWriter(out);
+	Word<T> residuals[3][block_size];
+	for (auto j = std::size_t{0}; j < n_columns; ++j)
+	{
+		auto n_predictors = j > 0 ? 3 : 2;
+		for (auto r0 = row_begin; r0 < row_end; r0 += block_size)
+		{
+			auto n = std::min(block_size, row_end - r0);
+
+			// Determine the residuals of all predictors and keep the narrowest ones.
+			auto predictor = 0;
+			auto width = 0;
+			for (auto k = 0; k < n_predictors; ++k)
+			{
+				auto combined = Word<T>{0};
+				for (auto i = std::size_t{0}; i < n; ++i)
+				{
+					auto x = to_word(values[(r0 + i) * n_columns + j]);
+					residuals[k][i] = residual<T>(x, predict(values, n_columns, row_begin, r0 + i, j, k));
+					combined |= residuals[k][i];
+				}
+				auto w = bit_width(combined);
+				if (k == 0 || w < width)
+				{
+					predictor = k;
+					width = w;
+				}
+			}
+
+			writer.put(static_cast<uint64_t>(predictor), 2);
+			writer.put(static_cast<uint64_t>(width), 7);
+			for (auto i = std::size_t{0}; i < n; ++i)
+				writer.put(residuals[predictor][i], width);
+		}
+	}
+	writer.flush();
+}
+
+template <typename T>
+bool
+decompress_chunk(char const* begin, char const* end, T* values, std::size_t n_columns,
+	std::size_t row_begin, std::size_t row_end)
+{
+	auto reader = BitReader(begin, end);
+	for (auto j = std::size_t{0}; j < n_columns; ++j)
+	{
+		auto n_predictors = j > 0 ? 3 : 2;
+		for (auto r0 = row_begin; r0 < row_end; r0 += block_size)
+		{
+			auto n = std::min(block_size, row_end - r0);
+			auto predictor = static_cast<int>(reader.get(2));
+			auto width = static_cast<int>(reader.get(7));
+			if (reader.failed() || predictor >= n_predictors || width > static_cast<int>(8 * sizeof(T)))
+				return false;
+
+			for (auto i = std::size_t{0}; i < n; ++i)
+			{
+				auto r = static_cast<Word<T>>(reader.get(width));
+				auto p = predict(values, n_columns, row_begin, r0 + i, j, predictor);
+				values[(r0 + i) * n_columns + j] = from_word<T>(reconstruct<T>(r, p));
+			}
+			if (reader.failed())
+				return false;
+		}
+	}
+	return true;
+}
+
+}
+
+template <typename T>
+std::vector<char>
+compress(T const* values, std::size_t n_rows, std::size_t n_columns)
+{
+	auto header = StreamHeader{};
+	header.n_rows = n_rows;
+	header.n_columns = static_cast<uint32_t>(n_columns);
+	header.chunk_rows = static_cast<uint32_t>(std::max(block_size,
+		chunk_values / std::max(n_columns, std::size_t{1}) / block_size * block_size));
+	header.value_size = sizeof(T);
+
+	auto n_chunks = (n_rows + header.chunk_rows - 1u) / header.chunk_rows;
+	auto chunks = std::vector<std::vector<char>>(n_chunks);
+#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < static_cast<int>(n_chunks); ++c)
+	{
+		auto row_begin = static_cast<std::size_t>(c) * header.chunk_rows;
+		auto row_end = std::min(n_rows, row_begin + header.chunk_rows);
+		compress_chunk(values, n_columns, row_begin, row_end, chunks[c]);
+	}
+
+	// The header is followed by the end offsets of the chunks and their data.
+	auto offsets = std::vector<uint64_t>(n_chunks);
+	auto offset = uint64_t{0};
+	for (auto c = std::size_t{0}; c < n_chunks; ++c)
+	{
+		offset += chunks[c].size();
+		offsets[c] = offset;
+	}
+
+	auto out = std::vector<char>(sizeof(header) + n_chunks * sizeof(uint64_t));
+	std::memcpy(out.data(), &header, sizeof(header));
+	std::memcpy(out.data() + sizeof(header), offsets.data(), n_chunks * sizeof(uint64_t));
+	out.reserve(out.size() + offset);
+	for (auto const& chunk : chunks)
+		out.insert(out.end(), chunk.begin(), chunk.end());
+	return out;
+}
+
+template <typename T>
+bool
+decompressedSize(char const* data, std::size_t size, std::size_t& n_values)
+{
+	auto header = StreamHeader{};
+	if (size < sizeof(header))
+		return false;
+	std::memcpy(&header, data, sizeof(header));
+	if (header.value_size != sizeof(T) || header.n_columns == 0u || header.chunk_rows == 0u ||
+		header.n_rows > std::numeric_limits<std::size_t>::max() / header.n_columns)
+		return false;
+	n_values = static_cast<std::size_t>(header.n_rows) * header.n_columns;
+	return true;
+}
+
+template <typename T>
+bool
+decompress(char const* data, std::size_t size, T* values, std::size_t n_values)
+{
+	auto n = std::size_t{};
+	if (!decompressedSize<T>(data, size, n) || n != n_values)
+		return false;
+
+	auto header = StreamHeader{};
+	std::memcpy(&header, data, sizeof(header));
+	auto n_rows = static_cast<std::size_t>(header.n_rows);
+	auto n_chunks = (n_rows + header.chunk_rows - 1u) / header.chunk_rows;
+	if (n_chunks > (size - sizeof(header)) / sizeof(uint64_t))
+		return false;
+
+	auto offsets = std::vector<uint64_t>(n_chunks);
+	std::memcpy(offsets.data(), data + sizeof(header), n_chunks * sizeof(uint64_t));
+	auto begin = data + sizeof(header) + n_chunks * sizeof(uint64_t);
+	auto available = static_cast<uint64_t>(data + size - begin);
+
+	auto valid = true;
+#pragma omp parallel for schedule(dynamic) reduction(&&: valid)
+	for (int c = 0; c < static_cast<int>(n_chunks); ++c)
+	{
+		auto chunk_begin = c > 0 ? offsets[c - 1] : uint64_t{0};
+		auto chunk_end = offsets[c];
+		if (chunk_begin > chunk_end || chunk_end > available)
+		{
+			valid = false;
+			continue;
+		}
+		auto row_begin = static_cast<std::size_t>(c) * header.chunk_rows;
+		auto row_end = std::min(n_rows, row_begin + header.chunk_rows);
+		valid = decompress_chunk(begin + chunk_begin, begin + chunk_end, values,
+			header.n_columns, row_begin, row_end) && valid;
+	}
+	return valid;
+}
+
+template std::vector<char> compress(float const*, std::size_t, std::size_t);
+template std::vector<char> compress(double const*, std::size_t, std::size_t);
+template std::vector<char> compress(int const*, std::size_t, std::size_t);
+template std::vector<char> compress(uint64_t const*, std::size_t, std::size_t);
+
+template bool decompressedSize<float>(char const*, std::size_t, std::size_t&);
+template bool decompressedSize<double>(char const*, std::size_t, std::size_t&);
+template bool decompressedSize<int>(char const*, std::size_t, std::size_t&);
+template bool decompressedSize<uint64_t>(char const*, std::size_t, std::size_t&);
+
+template bool decompress(char const*, std::size_t, float*, std::size_t);
+template bool decompress(char const*, std::size_t, double*, std::size_t);
+template bool decompress(char const*, std::size_t, int*, std::size_t);
+template bool decompress(char const*, std::size_t, uint64_t*, std::size_t);
+
+}
+}
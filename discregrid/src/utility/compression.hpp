@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace Discregrid
+{
+
+// Lossless codec for the arrays of a grid file. An array of n_rows x n_columns
+// values, e.g. the 32 node indices of each cell, is split into chunks of rows
+// that are compressed independently and can hence be encoded and decoded in
+// parallel. Within a chunk each column is predicted value by value from its
+// preceding values, either by the previous value or by linear extrapolation,
+// whichever fits a block of 32 values better. The residuals, i.e. the XOR of
+// the bit patterns for floating point values and the zigzag-encoded difference
+// for integers, are bit-packed with the width of the largest residual of their
+// block. Smooth fields hence compress well since their residuals are small.
+namespace compression
+{
+
+template <typename T>
+std::vector<char> compress(T const* values, std::size_t n_rows, std::size_t n_columns);
+
+// Determines the number of values of a compressed array. Returns false if data
+// does not hold a compressed array of values of type T.
+template <typename T>
+bool decompressedSize(char const* data, std::size_t size, std::size_t& n_values);
+
+// Decompresses an array of n_values values. Returns false if data is corrupted.
+template <typename T>
+bool decompress(char const* data, std::size_t size, T* values, std::size_t n_values);
+
+}
+}